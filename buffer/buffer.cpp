@@ -8,6 +8,7 @@
  */
 #include "buffer/buffer.h"
 #include "common/packet.h"
+#include "common/serialize.h"
 #include <algorithm>
 #include <cassert>
 
@@ -16,7 +17,7 @@ namespace GNN
 
   Buffer::Buffer(const std::string& _name, int num_channels, size_t capacity_per_channel)
     : SimObject(_name), num_channels_(num_channels), maxSizePerChannel_(capacity_per_channel),
-      drainEvent([this] { drainWrites(); }, _name + ".drainEvent")
+      drainEvent(*this, "drainEvent")
   {
     if (num_channels_ <= 0)
     {
@@ -40,7 +41,7 @@ namespace GNN
     {
       while (!q.empty())
       {
-        delete q.front();
+        PacketManager::free_packet(q.front());
         q.pop();
       }
     }
@@ -55,6 +56,20 @@ namespace GNN
             maxSizePerChannel_);
   }
 
+  void Buffer::serialize(SectionOut& os) const
+  {
+    for (const auto& q : writeQueues)
+      assert(q.empty());
+    os.put(outstandingWrites);
+    os.put(waitingRetry);
+  }
+
+  void Buffer::unserialize(SectionIn& is)
+  {
+    is.get(outstandingWrites);
+    is.get(waitingRetry);
+  }
+
   Port& Buffer::getPort(const std::string& if_name, int idx)
   {
     if (if_name.find("buf_side") == 0)
@@ -92,7 +107,7 @@ namespace GNN
     bool      ok  = enqueueWrite(channel, pkt);
     if (!ok)
     {
-      delete pkt;
+      PacketManager::free_packet(pkt);
     }
     return ok;
   }
@@ -141,7 +156,16 @@ namespace GNN
     }
 
     PacketPtr pkt = writeQueues[channel].front();
-    if (memPorts[channel].sendTimingReq(pkt))
+    if (isFunctional())
+    {
+      // 功能模式：写入即时完成，没有写响应，包由发送方归还
+      memPorts[channel].sendFunctional(pkt);
+      writeQueues[channel].pop();
+      waitingRetry[channel] = false;
+      PacketManager::free_packet(pkt);
+      return;
+    }
+    if (memPorts[channel].hasCredit() && memPorts[channel].sendTimingReq(pkt))
     {
       writeQueues[channel].pop();
       outstandingWrites[channel]++;
@@ -191,7 +215,7 @@ namespace GNN
   {
     if (channel < 0 || channel >= num_channels_)
     {
-      delete pkt;
+      PacketManager::free_packet(pkt);
       return false;
     }
 
@@ -211,7 +235,7 @@ namespace GNN
             pkt->getAddr(),
             outstandingWrites[channel]);
 
-    delete pkt;
+    PacketManager::free_packet(pkt);
 
     if (!writeQueues[channel].empty())
     {
@@ -247,6 +271,18 @@ namespace GNN
     }
   }
 
+  void Buffer::handleCredit(int channel)
+  {
+    // 信用归还发生在下游仲裁过程中，不在此处重入发送，交给 drainEvent
+    if (!waitingRetry[channel])
+      return;
+    waitingRetry[channel] = false;
+    if (!drainEvent.scheduled())
+    {
+      schedule(drainEvent, curTick() + 1);
+    }
+  }
+
   // MemSidePort 实现
   Buffer::MemSidePort::MemSidePort(const std::string& _name, Buffer& buf, int channel)
     : RequestPort(_name), buffer(buf), channel_id(channel)
@@ -263,4 +299,9 @@ namespace GNN
     buffer.handleRetry(channel_id);
   }
 
+  void Buffer::MemSidePort::recvCredit()
+  {
+    buffer.handleCredit(channel_id);
+  }
+
 }  // namespace GNN
\ No newline at end of file
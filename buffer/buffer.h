@@ -31,6 +31,9 @@ namespace GNN
         ~Buffer();
 
         void init() override;
+        // 检查点只在写队列排空时保存
+        void serialize(SectionOut &os) const override;
+        void unserialize(SectionIn &is) override;
 
         // 端口获取：名称形如 "<name>.buf_side<id>"
         Port &getPort(const std::string &if_name, int idx = -1) override;
@@ -51,6 +54,7 @@ namespace GNN
             MemSidePort(const std::string &_name, Buffer &buf, int channel);
             bool recvTimingResp(PacketPtr pkt) override;
             void recvReqRetry() override;
+            void recvCredit() override;
         };
 
     private:
@@ -59,6 +63,7 @@ namespace GNN
 
         bool recvTimingResp(int channel, PacketPtr pkt);
         void handleRetry(int channel);
+        void handleCredit(int channel);
         void trySendWrite(int channel);
         void drainWrites();
 
@@ -69,7 +74,7 @@ namespace GNN
         std::vector<size_t> outstandingWrites;
         std::vector<bool> waitingRetry;
 
-        EventFunctionWrapper drainEvent;
+        MemberEventWrapper<&Buffer::drainWrites> drainEvent;
     };
 
 } // namespace GNN
\ No newline at end of file
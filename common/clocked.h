@@ -0,0 +1,95 @@
+#ifndef GNN_COMMON_CLOCKED_H_
+#define GNN_COMMON_CLOCKED_H_
+
+#include "common/object.h"
+#include "common/serialize.h"
+#include "event/eventq.h"
+
+namespace GNN {
+
+// 带休眠/唤醒的时钟对象：
+// - 子类在构造时通过 setTickEvent() 登记自己的 tick 事件，tick 末尾判定自身静止时
+//   调用 sleep()，tick 事件改为在事件队列中空转（park），不再逐周期出队执行
+// - 空转的 tick 仍按逐周期调度时的位置推进，唤醒后原位入队，同周期内各事件的
+//   先后与从未休眠时完全一致
+// - 外部有新工作到达时调用 wake()；只需与 DRAM 时钟对齐的查询可调用 catchUp()，
+//   被跳过的空闲周期通过 skipCycles() 一次性补齐
+// - 空闲 tick 本身不改变状态的模块无需重载 skipCycles()
+class ClockedObject : public SimObject {
+private:
+  bool idleSkip_ = true;
+  bool sleeping_ = false;
+  Tick sleepTick_ = 0;         // 第一个尚未补齐的周期
+  uint64_t skippedCycles_ = 0; // 累计跳过的周期数（统计）
+  Event *tickEvent_ = nullptr;
+
+protected:
+  // 补齐 n 个空闲周期，默认空操作
+  virtual void skipCycles(Tick /*n*/) {}
+  void setTickEvent(Event &event) { tickEvent_ = &event; }
+
+public:
+  ClockedObject(const std::string &name) : SimObject(name) {}
+
+  // 关闭后 sleep() 不生效，对象逐周期 tick，用于校验休眠前后结果一致
+  void setIdleSkip(bool enable) { idleSkip_ = enable; }
+  bool asleep() const { return sleeping_; }
+  uint64_t skippedCycles() const { return skippedCycles_; }
+
+  // 代替调度下一周期的 tick 进入休眠；返回 false 表示未休眠，调用方需照常调度
+  bool sleep() {
+    if (!idleSkip_)
+      return false;
+    assert(tickEvent_ && !sleeping_);
+    sleeping_ = true;
+    sleepTick_ = curTick() + 1;
+    eventQueue()->park(tickEvent_, sleepTick_);
+    return true;
+  }
+
+  // 补齐空转 tick 已经经过的周期，保持休眠
+  void catchUp() {
+    if (!sleeping_ || tickEvent_->when() <= sleepTick_)
+      return;
+    Tick n = tickEvent_->when() - sleepTick_;
+    skipCycles(n);
+    skippedCycles_ += n;
+    sleepTick_ = tickEvent_->when();
+  }
+
+  // 补齐空闲周期并在空转到的位置恢复 tick；未休眠时返回 false
+  bool wake() {
+    if (!sleeping_)
+      return false;
+    catchUp();
+    sleeping_ = false;
+    eventQueue()->unpark(tickEvent_);
+    return true;
+  }
+
+  // 检查点只在事件队列排空时保存，此时 tick 要么在空转、要么已停止。
+  // 子类重载时先调用基类版本
+  void serialize(SectionOut &os) const override {
+    assert(!tickEvent_ || !tickEvent_->scheduled());
+    os.put(sleeping_);
+    os.put(sleepTick_);
+    os.put(skippedCycles_);
+    if (sleeping_) {
+      os.put(tickEvent_->when());
+      os.put(tickEvent_->seq());
+    }
+  }
+  void unserialize(SectionIn &is) override {
+    is.get(sleeping_);
+    is.get(sleepTick_);
+    is.get(skippedCycles_);
+    if (sleeping_) {
+      Tick when = is.get<Tick>();
+      eventQueue()->parkAt(tickEvent_, when, is.get<uint64_t>());
+    }
+  }
+};
+
+} // namespace GNN
+
+#endif // GNN_COMMON_CLOCKED_H_
@@ -1,11 +1,14 @@
 #include "object.h"
+#include "common/serialize.h"
 #include <cassert>
+#include <stdexcept>
 
 namespace GNN
 {
 // 静态成员：所有SimObject实例列表
 SimObject::SimObjectList SimObject::simObjectList;
 SimObjectResolver *SimObject::_objNameResolver = NULL;
+SimObject::MemoryMode SimObject::_memoryMode = SimObject::MemoryMode::Timing;
 
 // 构造函数：加入全局对象列表，初始化探针管理器
 SimObject::SimObject(const std::string &_name) :Named(_name+".Event"){
@@ -22,6 +25,20 @@ void SimObject::init() {
 
 }
 
+// 存储访问模式切换（子类可重载）
+void SimObject::memoryModeChanged() {}
+
+// 归还持有的数据包（子类可重载）
+void SimObject::releasePackets() {}
+
+void SimObject::setMemoryMode(MemoryMode mode) {
+    if (mode == _memoryMode)
+        return;
+    _memoryMode = mode;
+    for (SimObject *obj : simObjectList)
+        obj->memoryModeChanged();
+}
+
 // 注册探针点（子类可重载）
 void SimObject::regProbePoints() {}
 
@@ -59,6 +76,39 @@ SimObject *SimObject::find(const char *name) {
     return nullptr;
 }
 
+// 保存时刻、插入序号与全部对象状态。只支持排空的边界：队列中没有待处理事件，
+// 只剩休眠对象空转的 tick，由各 ClockedObject 自己保存
+void SimObject::serializeAll(CheckpointOut &cp) {
+    assert(gSim->empty());
+    SectionOut os;
+    os.put(gSim->getCurTick());
+    os.put(gSim->seqCounter());
+    os.put(static_cast<uint64_t>(simObjectList.size()));
+    cp.section("eventq", os);
+    for (auto *obj : simObjectList) {
+        SectionOut obj_os;
+        obj->serialize(obj_os);
+        cp.section(obj->name(), obj_os);
+    }
+}
+
+// init() 调度的事件全部撤销，由各对象按检查点重新登记
+void SimObject::unserializeAll(CheckpointIn &cp) {
+    assert(PacketPool::local().outstanding() == 0);
+    SectionIn is = cp.in("eventq");
+    Tick tick = is.get<Tick>();
+    uint64_t seq = is.get<uint64_t>();
+    if (is.get<uint64_t>() != simObjectList.size())
+        throw std::runtime_error("checkpoint object count mismatch");
+    is.done();
+    gSim->restart(tick, seq);
+    for (auto *obj : simObjectList) {
+        SectionIn obj_is = cp.in(obj->name());
+        obj->unserialize(obj_is);
+        obj_is.done();
+    }
+}
+
 // 设置名字解析器
 void SimObject::setSimObjectResolver(SimObjectResolver *resolver) {
     _objNameResolver = resolver;
@@ -12,6 +12,10 @@ namespace GNN
 
 class EventManager;
 class ProbeManager;
+class SectionOut;
+class SectionIn;
+class CheckpointOut;
+class CheckpointIn;
 class SimObjectResolver;
 
 // 仿真对象基类，所有模块继承自它
@@ -39,6 +43,13 @@ class SimObject : public EventManager, public Named
     virtual Port &getPort(const std::string &if_name, int idx=-1);
     // 启动（仿真前最后初始化）
     virtual void startup();
+    // 存储访问模式切换后调用（子类可重载，如恢复休眠的 tick）
+    virtual void memoryModeChanged();
+    // 仿真结束后归还本对象仍持有的数据包（如缓冲中未被消费的数据），之后不再推进
+    virtual void releasePackets();
+    // 检查点：按名字各存一个 section，默认无状态需要保存
+    virtual void serialize(SectionOut &os) const { }
+    virtual void unserialize(SectionIn &is) { }
 
 
     // 静态：通过名字查找SimObject
@@ -46,6 +57,20 @@ class SimObject : public EventManager, public Named
     // 设置/获取名字解析器
     static void setSimObjectResolver(SimObjectResolver *resolver);
     static SimObjectResolver *getSimObjectResolver();
+    // 在事件队列排空的边界保存全部对象；恢复须在 init() 之后、仿真开始前调用
+    static void serializeAll(CheckpointOut &cp);
+    static void unserializeAll(CheckpointIn &cp);
+
+    // 存储访问模式：Timing 走端口时序协议；Functional 下存储侧
+    // (DMA Bank / DramArb / DRAMsim3) 通过 sendFunctional 即时应答
+    enum class MemoryMode { Timing, Functional };
+    // 模式改变时通知所有对象
+    static void setMemoryMode(MemoryMode mode);
+    static MemoryMode memoryMode() { return _memoryMode; }
+    static bool isFunctional() { return _memoryMode == MemoryMode::Functional; }
+
+  private:
+    static MemoryMode _memoryMode;
 };
 
 #define PARAMS(type)
@@ -1,24 +1,98 @@
 #ifndef __COMMON_PACKET_H__
 #define __COMMON_PACKET_H__
 
+#include <algorithm>
+#include <cassert>
 #include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include "common/common.h"
 #include "common/define.h"
 // 简单的数据包类，只用于数据搬运
 namespace GNN
 {
+// 指向包内数据的可写视图，生产者直接原地写入
+struct PacketSpan {
+    storage_t* ptr;
+    size_t len;
+    storage_t& operator[](size_t i) const { return ptr[i]; }
+    storage_t* begin() const { return ptr; }
+    storage_t* end() const { return ptr + len; }
+    size_t size() const { return len; }
+};
+
+// 包数据：一个 burst 以内直接存放在包内，仅多 burst 合并包溢出到堆上
+class PacketPayload {
+public:
+    static constexpr size_t kInlineWords = BURST_BITS / STORAGE_SIZE;
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    const storage_t* data() const { return spilled ? heap.data() : inlineBuf; }
+    storage_t* data() { return spilled ? heap.data() : inlineBuf; }
+    // 越过 size() 的槽位是复用前的残留，读到的值不确定
+    const storage_t& operator[](size_t i) const { assert(i < _size); return data()[i]; }
+    storage_t& operator[](size_t i) { assert(i < _size); return data()[i]; }
+    const storage_t* begin() const { return data(); }
+    const storage_t* end() const { return data() + _size; }
+
+    // 清空，堆上已分配的容量保留给下次合并复用
+    void clear() {
+        _size = 0;
+        spilled = false;
+    }
+
+    // 调整大小并保留已有内容，新增部分清零
+    void resize(size_t n) {
+        if (n > kInlineWords && !spilled) {
+            heap.resize(std::max(n, heap.size()));
+            std::memcpy(heap.data(), inlineBuf, _size * sizeof(storage_t));
+            spilled = true;
+        } else if (spilled && n > heap.size()) {
+            heap.resize(n);
+        }
+        if (n > _size)
+            std::memset(data() + _size, 0, (n - _size) * sizeof(storage_t));
+        _size = n;
+    }
+
+    void assign(const storage_t* src, size_t n) {
+        clear();
+        resize(n);
+        if (n)
+            std::memcpy(data(), src, n * sizeof(storage_t));
+    }
+
+    void append(const storage_t* src, size_t n) {
+        size_t old = _size;
+        resize(old + n);
+        if (n)
+            std::memcpy(data() + old, src, n * sizeof(storage_t));
+    }
+
+private:
+    storage_t inlineBuf[kInlineWords];
+    std::vector<storage_t> heap;
+    size_t _size = 0;
+    bool spilled = false;
+};
+
 class DataPacket {
 private:
     addr_t addr;                    // 内存地址
     size_t size;                      // 数据大小
-    std::vector<storage_t> data;        // 数据内容
+    PacketPayload data;                // 数据内容
     bool is_write;                     // 是否为写操作
     int bank_id = -1;                  // 关联的bank编号（可选元信息）
     int buffer_idx = -1;               // 关联的缓冲索引（可选元信息）
     uint64_t cmd_id_ = 0;              // 指令id
+    int trans_id_ = -1;                // 在途事务号（TransTable 索引），-1 表示未登记
     bool weight_buffer_is_clear = false; //
     bool feature_buffer_is_clear = false; //
+    bool in_use_ = false;              // 对象池标记：已分配未释放
+    friend class PacketPool;
 public:
     // 构造函数
     DataPacket(addr_t a =0 , size_t s =0 , bool read = true, uint64_t cmd_id = 0) 
@@ -26,6 +100,20 @@ public:
     
     // 析构函数
     ~DataPacket() = default;
+
+    // 复用时重置全部字段，data 保留已分配的容量
+    void reset(addr_t a, size_t s, bool write, uint64_t cmd_id = 0) {
+        addr = a;
+        size = s;
+        data.clear();
+        is_write = write;
+        bank_id = -1;
+        buffer_idx = -1;
+        cmd_id_ = cmd_id;
+        trans_id_ = -1;
+        weight_buffer_is_clear = false;
+        feature_buffer_is_clear = false;
+    }
     
     // 获取地址
     addr_t getAddr() const { return addr; }
@@ -34,7 +122,7 @@ public:
     size_t getSize() const { return size; }
     
     // 获取数据
-    const std::vector<storage_t>& getData() const { return data; }
+    const PacketPayload& getData() const { return data; }
     
     // 是否为读操作
     bool isRead() const { return !is_write; }
@@ -42,7 +130,14 @@ public:
     bool isWrite() const { return is_write; }
     // 设置数据
     void setData(const std::vector<storage_t>& d) {
-        data = d;
+        data.assign(d.data(), d.size());
+    }
+    void setData(const storage_t* d, size_t n) { data.assign(d, n); }
+    // 将数据调整为 n 个字（清零）并返回可写视图，供生产者原地填充
+    PacketSpan mutableData(size_t n) {
+        data.clear();
+        data.resize(n);
+        return { data.data(), n };
     }
     
     // 设置地址
@@ -59,6 +154,9 @@ public:
     int getBankId() const { return bank_id; }
     void setBufferIdx(int v) { buffer_idx = v; }
     int getBufferIdx() const { return buffer_idx; }
+    // 事务号：由发出方在事务表中登记，完成时据此直接找回表项
+    void setTransId(int v) { trans_id_ = v; }
+    int getTransId() const { return trans_id_; }
     // 设置权重缓冲区是否为空
     void setWeightBufferIsClear(bool v) { weight_buffer_is_clear = v; }
     bool getWeightBufferIsClear() const { return weight_buffer_is_clear; }
@@ -70,6 +168,72 @@ public:
 // 简单的指针类型
 typedef DataPacket* PacketPtr;
 
+// 每线程 DataPacket 对象池：按 slab 批量构造，释放后进入本线程空闲链表复用，
+// 避免每个 burst 一次 new/delete。slab 归全局所有、进程结束时统一释放，
+// 因此包可以在其他线程（分区）释放。统计按线程计。
+class PacketPool {
+public:
+    static constexpr size_t kSlabPackets = 256;
+
+    static PacketPool& local() {
+        thread_local PacketPool pool;
+        return pool;
+    }
+
+    PacketPtr alloc(addr_t addr, size_t size, bool write) {
+        if (freeList.empty())
+            grow();
+        PacketPtr pkt = freeList.back();
+        freeList.pop_back();
+        pkt->reset(addr, size, write);
+        pkt->in_use_ = true;
+        ++_allocs;
+        if (++_outstanding > _highWater)
+            _highWater = _outstanding;
+        return pkt;
+    }
+
+    void release(PacketPtr pkt) {
+        if (!pkt)
+            return;
+        assert(pkt->in_use_ && "packet double free or not from PacketPool");
+        pkt->in_use_ = false;
+        --_outstanding;
+        freeList.push_back(pkt);
+    }
+
+    // 当前未释放的包数（跨线程释放时单线程计数可能为负）
+    int64_t outstanding() const { return _outstanding; }
+    int64_t highWater() const { return _highWater; }
+    uint64_t allocs() const { return _allocs; }
+    uint64_t capacity() const { return _capacity; }
+
+private:
+    std::vector<PacketPtr> freeList;
+    int64_t _outstanding = 0;
+    int64_t _highWater = 0;
+    uint64_t _allocs = 0;
+    uint64_t _capacity = 0;
+
+    static std::vector<std::unique_ptr<DataPacket[]>>& slabs() {
+        static std::vector<std::unique_ptr<DataPacket[]>> s;
+        return s;
+    }
+
+    void grow() {
+        static std::mutex slabMutex;
+        DataPacket* slab = new DataPacket[kSlabPackets];
+        {
+            std::lock_guard<std::mutex> lk(slabMutex);
+            slabs().emplace_back(slab);
+        }
+        freeList.reserve(freeList.size() + kSlabPackets);
+        for (size_t i = kSlabPackets; i-- > 0;)
+            freeList.push_back(&slab[i]);
+        _capacity += kSlabPackets;
+    }
+};
+
 // 简单的队列类
 class PacketQueue {
 private:
@@ -120,19 +284,19 @@ public:
     public:
      // 创建读数据包
     static PacketPtr create_read_packet(addr_t addr, size_t size) {
-        return new DataPacket(addr, size, true);
+        return PacketPool::local().alloc(addr, size, true);
     }
     
     // 创建写数据包
     static PacketPtr create_write_packet(addr_t addr, const std::vector<storage_t>& data) {
-        auto packet = new DataPacket(addr, data.size(), false);
+        auto packet = PacketPool::local().alloc(addr, data.size(), false);
         packet->setData(data);
         return packet;
     }
     
     // 释放数据包
     static void free_packet(PacketPtr packet) {
-        delete packet;
+        PacketPool::local().release(packet);
     }
     
     // 批量创建读数据包
@@ -148,7 +312,7 @@ public:
     // 批量释放数据包
     static void free_packets(const std::vector<PacketPtr>& packets) {
         for (auto packet : packets) {
-            delete packet;
+            PacketPool::local().release(packet);
         }
     }
 };
@@ -158,19 +322,26 @@ class PacketManager {
 public:
     // 创建读数据包
     static PacketPtr create_read_packet(addr_t addr, size_t size) {
-        return new DataPacket(addr, size, 0);
+        return PacketPool::local().alloc(addr, size, false);
     }
     
     // 创建写数据包
     static PacketPtr create_write_packet(addr_t addr, const std::vector<storage_t>& data) {
-        auto packet = new DataPacket(addr, data.size(), 1);
+        auto packet = PacketPool::local().alloc(addr, data.size(), true);
         packet->setData(data);
         return packet;
     }
+
+    // 创建 words 个字的写数据包（清零），由调用者通过 mutableData 原地填充
+    static PacketPtr create_write_packet(addr_t addr, size_t words) {
+        auto packet = PacketPool::local().alloc(addr, words, true);
+        packet->mutableData(words);
+        return packet;
+    }
     
     // 释放数据包
     static void free_packet(PacketPtr packet) {
-        delete packet;
+        PacketPool::local().release(packet);
     }
     
     // 批量创建读数据包
@@ -186,7 +357,7 @@ public:
     // 批量释放数据包
     static void free_packets(const std::vector<PacketPtr>& packets) {
         for (auto packet : packets) {
-            delete packet;
+            PacketPool::local().release(packet);
         }
     }
 };
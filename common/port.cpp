@@ -25,6 +25,7 @@ public:
   // Timing protocol.
   bool recvTimingReq(PacketPtr) override { blowUp(); }
   bool tryTiming(PacketPtr) override { blowUp(); }
+  void recvFunctional(PacketPtr) override { blowUp(); }
   void recvRespRetry() override { blowUp(); }
 };
 } // namespace
@@ -39,7 +40,8 @@ DefaultResponsePort defaultResponsePort;
  * OK until definitive removal of owner.
  */
 RequestPort::RequestPort(const std::string &name)
-    : Port(name), _responsePort(&defaultResponsePort) {}
+    : Port(name), _creditMode(false), _credits(0),
+      _responsePort(&defaultResponsePort) {}
 RequestPort::~RequestPort() {}
 
 void RequestPort::bind(Port &peer) {
@@ -52,6 +54,8 @@ void RequestPort::bind(Port &peer) {
 
 void RequestPort::unbind() {
   _responsePort->responderUnbind();
+  _creditMode = false;
+  _credits = 0;
   _responsePort = &defaultResponsePort;
   Port::unbind();
 }
@@ -4,6 +4,7 @@
 
 #include <cassert>
 #include <ostream>
+#include <stdexcept>
 #include <string>
 
 #include "common.h"
@@ -16,6 +17,13 @@ namespace GNN
 {
 class ResponsePort;
 class Port;
+
+// 解析端口名末尾的编号，如 "bmap_dma_side12" -> 12（支持多位数通道编号）
+inline int portIndexSuffix(const std::string &if_name)
+{
+  size_t pos = if_name.find_last_not_of("0123456789") + 1;
+  return pos < if_name.size() ? std::stoi(if_name.substr(pos)) : -1;
+}
 class Port
 {
 private:
@@ -77,7 +85,9 @@ class RequestPort : public Port, public TimingRequestProtocol
   friend class ResponsePort;
 
 private:
-
+  // 信用流控状态：由响应端 grantCredits() 开启，未开启时走原有的拒绝/重试协议
+  bool _creditMode;
+  int _credits;
 
 protected:
 public:
@@ -153,7 +163,24 @@ public:
    */
   virtual void sendRetryResp();
 
+  /* 可选的信用流控 (credit-based flow control)。 */
+
+  /**
+   * 响应端通告了缓冲信用后，请求端只在持有信用时发送，发送必定成功，
+   * 不再出现拒绝与重试；信用在响应端释放对应缓冲项时归还。
+   */
+  bool creditMode() const { return _creditMode; }
+  int credits() const { return _credits; }
+  // 非信用模式恒为 true，调用方可无条件检查
+  bool hasCredit() const { return !_creditMode || _credits > 0; }
+
 protected:
+  /**
+   * 响应端归还信用时调用。信用模式下代替 recvReqRetry 唤醒因缺信用
+   * 而暂停发送的请求端；默认不做任何事。
+   */
+  virtual void recvCredit() {}
+
   /**
    * Called to receive an address range change from the peer response
    * port. The default implementation ignores the change and does
@@ -205,6 +232,15 @@ protected:
     return 0;
   }
 
+  /**
+   * 功能访问：在调用返回前完成整个访问，不占用时序资源、不会被拒绝。
+   * 需要支持功能模式的响应端重载，默认视为连接错误。
+   */
+  virtual void recvFunctional(PacketPtr pkt)
+  {
+    throw std::runtime_error(name() + " was not expecting a functional access");
+  }
+
 public:
   /* The timing protocol. */
 
@@ -252,6 +288,26 @@ public:
     }
   }
 
+  /**
+   * 向请求端通告 n 个缓冲信用并开启信用流控（需在绑定之后调用）。
+   */
+  void grantCredits(int n)
+  {
+    assert(n > 0);
+    _requestPort->_creditMode = true;
+    _requestPort->_credits += n;
+  }
+
+  /**
+   * 释放一个缓冲项后将信用归还给请求端。
+   */
+  void returnCredit(int n = 1)
+  {
+    assert(_requestPort->_creditMode);
+    _requestPort->_credits += n;
+    _requestPort->recvCredit();
+  }
+
 protected:
   /**
    * Called by the request port to unbind. Should never be called
@@ -273,7 +329,16 @@ public:
 inline bool RequestPort::sendTimingReq(PacketPtr pkt)
 {
   try
-  {   
+  {
+    if (_creditMode)
+    {
+      // 信用模式：持有信用即保证对端有缓冲，发送不会被拒绝
+      assert(_credits > 0);
+      bool succ = TimingRequestProtocol::sendReq(_responsePort, pkt);
+      assert(succ);
+      --_credits;
+      return succ;
+    }
     bool succ = TimingRequestProtocol::sendReq(_responsePort, pkt);
     return succ;
   }
@@ -284,6 +349,18 @@ inline bool RequestPort::sendTimingReq(PacketPtr pkt)
   }
 }
 
+inline void RequestPort::sendFunctional(PacketPtr pkt) const
+{
+  try
+  {
+    _responsePort->recvFunctional(pkt);
+  }
+  catch (UnboundPortException)
+  {
+    reportUnbound();
+  }
+}
+
 inline bool RequestPort::tryTiming(PacketPtr pkt) const
 {
   try
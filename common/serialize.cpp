@@ -0,0 +1,214 @@
+#include "common/serialize.h"
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace GNN {
+
+static uint64_t alignUp(uint64_t v) {
+  return (v + kCkptAlign - 1) / kCkptAlign * kCkptAlign;
+}
+
+void SectionOut::put(const std::string &v) {
+  put(static_cast<uint64_t>(v.size()));
+  append(v.data(), v.size());
+}
+
+void SectionOut::put(const std::vector<bool> &v) {
+  put(static_cast<uint64_t>(v.size()));
+  for (bool b : v)
+    put(static_cast<uint8_t>(b));
+}
+
+void SectionOut::put(const DataPacket *pkt) {
+  put(static_cast<uint8_t>(pkt != nullptr));
+  if (!pkt)
+    return;
+  put(static_cast<uint64_t>(pkt->getAddr()));
+  put(static_cast<uint64_t>(pkt->getSize()));
+  put(pkt->isWrite());
+  put(pkt->getBankId());
+  put(pkt->getBufferIdx());
+  put(pkt->getCmdId());
+  put(pkt->getTransId());
+  put(pkt->getWeightBufferIsClear());
+  put(pkt->getFeatureBufferIsClear());
+  const PacketPayload &d = pkt->getData();
+  put(static_cast<uint64_t>(d.size()));
+  append(d.data(), d.size() * sizeof(storage_t));
+}
+
+void SectionIn::get(std::string &v) {
+  v.resize(count());
+  take(&v[0], v.size());
+}
+
+void SectionIn::get(std::vector<bool> &v) {
+  v.resize(count());
+  for (size_t i = 0; i < v.size(); ++i)
+    v[i] = get<uint8_t>() != 0;
+}
+
+void SectionIn::get(PacketPtr &pkt) {
+  pkt = nullptr;
+  if (!get<uint8_t>())
+    return;
+  addr_t addr = static_cast<addr_t>(get<uint64_t>());
+  size_t size = static_cast<size_t>(get<uint64_t>());
+  bool write = get<bool>();
+  pkt = PacketPool::local().alloc(addr, size, write);
+  pkt->setBankId(get<int>());
+  pkt->setBufferIdx(get<int>());
+  pkt->setCmdId(get<uint64_t>());
+  pkt->setTransId(get<int>());
+  pkt->setWeightBufferIsClear(get<bool>());
+  pkt->setFeatureBufferIsClear(get<bool>());
+  size_t words = count();
+  PacketSpan span = pkt->mutableData(words);
+  take(span.ptr, words * sizeof(storage_t));
+}
+
+void SectionIn::done() const {
+  if (pos != length)
+    throw std::runtime_error("checkpoint section not fully consumed: " + name);
+}
+
+void SectionIn::fail() const {
+  throw std::runtime_error("checkpoint section truncated: " + name);
+}
+
+CheckpointOut::CheckpointOut(const std::string &path)
+    : path(path), closed(false) {}
+
+CheckpointOut::~CheckpointOut() {
+  if (closed)
+    return;
+  try {
+    close();
+  } catch (const std::runtime_error &) {
+    // 析构中不抛异常，需要错误信息时显式调用 close()
+  }
+}
+
+void CheckpointOut::section(const std::string &name, const void *data,
+                            size_t bytes) {
+  if (name.size() >= sizeof(CkptSectionEntry::name))
+    throw std::runtime_error("checkpoint section name too long: " + name);
+  sections.push_back({name, data, bytes});
+}
+
+void CheckpointOut::close() {
+  closed = true;
+  std::FILE *fp = std::fopen(path.c_str(), "wb");
+  if (!fp)
+    throw std::runtime_error("cannot open checkpoint for write: " + path);
+
+  CkptHeader hdr{kCkptMagic, kCkptVersion,
+                 static_cast<uint32_t>(sections.size())};
+  std::vector<CkptSectionEntry> table(sections.size());
+  uint64_t offset =
+      alignUp(sizeof(CkptHeader) + sizeof(CkptSectionEntry) * table.size());
+  for (size_t i = 0; i < sections.size(); ++i) {
+    std::memset(table[i].name, 0, sizeof(table[i].name));
+    std::memcpy(table[i].name, sections[i].name.data(),
+                sections[i].name.size());
+    table[i].offset = offset;
+    table[i].size = sections[i].size;
+    offset = alignUp(offset + sections[i].size);
+  }
+
+  bool ok = std::fwrite(&hdr, sizeof(hdr), 1, fp) == 1;
+  if (!table.empty())
+    ok = ok && std::fwrite(table.data(), sizeof(CkptSectionEntry),
+                           table.size(), fp) == table.size();
+  for (size_t i = 0; i < sections.size() && ok; ++i) {
+    ok = std::fseek(fp, static_cast<long>(table[i].offset), SEEK_SET) == 0;
+    if (ok && sections[i].size)
+      ok = std::fwrite(sections[i].data, 1, sections[i].size, fp) ==
+           sections[i].size;
+  }
+  // 末尾补齐到页边界，保证最后一个 section 可整页映射
+  if (ok && offset > 0) {
+    ok = std::fseek(fp, static_cast<long>(offset - 1), SEEK_SET) == 0 &&
+         std::fputc(0, fp) != EOF;
+  }
+  ok = (std::fclose(fp) == 0) && ok;
+  sections.clear();
+  owned.clear();
+  if (!ok)
+    throw std::runtime_error("failed to write checkpoint: " + path);
+}
+
+CheckpointIn::CheckpointIn(const std::string &path)
+    : path(path), base(nullptr), length(0), entries(nullptr), num_sections(0) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error("cannot open checkpoint: " + path);
+  struct stat st;
+  if (::fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(CkptHeader)) {
+    ::close(fd);
+    throw std::runtime_error("invalid checkpoint: " + path);
+  }
+  length = static_cast<size_t>(st.st_size);
+  void *p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED)
+    throw std::runtime_error("cannot mmap checkpoint: " + path);
+  base = static_cast<const char *>(p);
+
+  const CkptHeader *hdr = reinterpret_cast<const CkptHeader *>(base);
+  num_sections = hdr->num_sections;
+  if (hdr->magic != kCkptMagic || hdr->version != kCkptVersion ||
+      sizeof(CkptHeader) + sizeof(CkptSectionEntry) * num_sections > length) {
+    ::munmap(const_cast<char *>(base), length);
+    base = nullptr;
+    throw std::runtime_error("checkpoint format mismatch: " + path);
+  }
+  entries = reinterpret_cast<const CkptSectionEntry *>(base + sizeof(CkptHeader));
+  for (uint32_t i = 0; i < num_sections; ++i) {
+    if (entries[i].offset + entries[i].size > length) {
+      ::munmap(const_cast<char *>(base), length);
+      base = nullptr;
+      throw std::runtime_error("truncated checkpoint: " + path);
+    }
+  }
+}
+
+CheckpointIn::~CheckpointIn() {
+  if (base)
+    ::munmap(const_cast<char *>(base), length);
+}
+
+bool CheckpointIn::has(const std::string &name) const {
+  for (uint32_t i = 0; i < num_sections; ++i)
+    if (std::strncmp(entries[i].name, name.c_str(),
+                     sizeof(entries[i].name)) == 0)
+      return true;
+  return false;
+}
+
+const void *CheckpointIn::section(const std::string &name,
+                                  size_t &bytes) const {
+  for (uint32_t i = 0; i < num_sections; ++i) {
+    if (std::strncmp(entries[i].name, name.c_str(),
+                     sizeof(entries[i].name)) == 0) {
+      bytes = entries[i].size;
+      return base + entries[i].offset;
+    }
+  }
+  throw std::runtime_error("checkpoint section not found: " + name);
+}
+
+void CheckpointIn::copyOut(const std::string &name, const void *src,
+                           size_t bytes, void *dst, size_t expect) {
+  if (bytes != expect)
+    throw std::runtime_error("checkpoint section size mismatch: " + name);
+  std::memcpy(dst, src, bytes);
+}
+
+} // namespace GNN
@@ -0,0 +1,211 @@
+#ifndef GNN_COMMON_SERIALIZE_H_
+#define GNN_COMMON_SERIALIZE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "common/packet.h"
+
+namespace GNN {
+
+// 检查点文件格式（小端，按页对齐，便于 mmap 后直接引用）：
+//   [Header][SectionEntry * num_sections][pad][section 0 data][pad][section 1 data]...
+// 每个 section 由名字索引，数据起始偏移按 kCkptAlign 对齐
+static constexpr uint64_t kCkptMagic = 0x54504b434e4e47ULL; // "GNNCKPT"
+static constexpr uint32_t kCkptVersion = 1;
+static constexpr uint64_t kCkptAlign = 4096;
+
+struct CkptHeader {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t num_sections;
+};
+
+struct CkptSectionEntry {
+  char name[48];
+  uint64_t offset;
+  uint64_t size;
+};
+
+// 对象状态的字节流：各 SimObject 在 serialize() 中按固定顺序写入，
+// unserialize() 中按同样顺序读出。只接受平凡可拷贝类型与下列容器，指针必须显式处理
+class SectionOut {
+public:
+  template <typename T>
+  typename std::enable_if<std::is_trivially_copyable<T>::value &&
+                          !std::is_pointer<T>::value>::type
+  put(const T &v) {
+    append(&v, sizeof(T));
+  }
+  void put(const std::string &v);
+  void put(const std::vector<bool> &v);
+  // 数据包按值保存（含数据内容），空指针只记一个标记
+  void put(const DataPacket *pkt);
+  template <typename T> void put(const std::vector<T> &v) {
+    put(static_cast<uint64_t>(v.size()));
+    if constexpr (std::is_trivially_copyable<T>::value && !std::is_pointer<T>::value)
+      append(v.data(), v.size() * sizeof(T));
+    else
+      for (const auto &e : v)
+        put(e);
+  }
+  template <typename T> void put(const std::deque<T> &v) {
+    put(static_cast<uint64_t>(v.size()));
+    for (const auto &e : v)
+      put(e);
+  }
+
+  const std::vector<char> &bytes() const { return buf; }
+
+private:
+  void append(const void *p, size_t n) {
+    const char *c = static_cast<const char *>(p);
+    buf.insert(buf.end(), c, c + n);
+  }
+  std::vector<char> buf;
+};
+
+// 读回 SectionOut 写出的字节流；越界或未读完时抛出 std::runtime_error
+class SectionIn {
+public:
+  SectionIn(const std::string &name, const void *data, size_t bytes)
+      : name(name), base(static_cast<const char *>(data)), length(bytes), pos(0) {}
+
+  template <typename T>
+  typename std::enable_if<std::is_trivially_copyable<T>::value &&
+                          !std::is_pointer<T>::value>::type
+  get(T &v) {
+    take(&v, sizeof(T));
+  }
+  void get(std::string &v);
+  void get(std::vector<bool> &v);
+  // 从本线程对象池重新分配数据包，原为空指针时返回 nullptr
+  void get(PacketPtr &pkt);
+  template <typename T> void get(std::vector<T> &v) {
+    v.resize(count());
+    if constexpr (std::is_trivially_copyable<T>::value && !std::is_pointer<T>::value)
+      take(v.data(), v.size() * sizeof(T));
+    else
+      for (auto &e : v)
+        get(e);
+  }
+  template <typename T> void get(std::deque<T> &v) {
+    v.resize(count());
+    for (auto &e : v)
+      get(e);
+  }
+  template <typename T> T get() {
+    T v{};
+    get(v);
+    return v;
+  }
+
+  // 校验整个 section 恰好读完，防止读写顺序不一致时悄悄错位
+  void done() const;
+
+private:
+  size_t count() {
+    uint64_t n = 0;
+    get(n);
+    if (n > length - pos)
+      fail();
+    return static_cast<size_t>(n);
+  }
+  void take(void *dst, size_t n) {
+    if (n > length - pos)
+      fail();
+    if (n)
+      std::memcpy(dst, base + pos, n);
+    pos += n;
+  }
+  [[noreturn]] void fail() const;
+  std::string name;
+  const char *base;
+  size_t length;
+  size_t pos;
+};
+
+// 写检查点：先收集各 section，close() 时一次性写出
+class CheckpointOut {
+public:
+  explicit CheckpointOut(const std::string &path);
+  ~CheckpointOut();
+
+  // 原始字节 section，数据在 close() 前必须保持有效
+  void section(const std::string &name, const void *data, size_t bytes);
+
+  // 平凡可拷贝标量/结构体
+  template <typename T> void param(const std::string &name, const T &v) {
+    static_assert(std::is_trivially_copyable<T>::value, "param needs POD");
+    owned.emplace_back(reinterpret_cast<const char *>(&v),
+                       reinterpret_cast<const char *>(&v) + sizeof(T));
+    section(name, owned.back().data(), sizeof(T));
+  }
+  void param(const std::string &name, const std::string &v) {
+    owned.emplace_back(v.begin(), v.end());
+    section(name, owned.back().data(), v.size());
+  }
+  void section(const std::string &name, const SectionOut &os) {
+    owned.push_back(os.bytes());
+    section(name, owned.back().data(), owned.back().size());
+  }
+
+  void close();
+
+private:
+  struct Pending {
+    std::string name;
+    const void *data;
+    size_t size;
+  };
+  std::string path;
+  std::vector<Pending> sections;
+  std::vector<std::vector<char>> owned;
+  bool closed;
+};
+
+// 读检查点：整个文件只读 mmap，section 数据直接指向映射区域
+class CheckpointIn {
+public:
+  // 文件不存在或格式不符时抛出 std::runtime_error
+  explicit CheckpointIn(const std::string &path);
+  ~CheckpointIn();
+
+  bool has(const std::string &name) const;
+  // 返回映射区域内的指针，生命周期与 CheckpointIn 相同
+  const void *section(const std::string &name, size_t &bytes) const;
+
+  template <typename T> void param(const std::string &name, T &v) const {
+    static_assert(std::is_trivially_copyable<T>::value, "param needs POD");
+    size_t bytes = 0;
+    const void *p = section(name, bytes);
+    copyOut(name, p, bytes, &v, sizeof(T));
+  }
+  void param(const std::string &name, std::string &v) const {
+    size_t bytes = 0;
+    const char *p = static_cast<const char *>(section(name, bytes));
+    v.assign(p, bytes);
+  }
+  SectionIn in(const std::string &name) const {
+    size_t bytes = 0;
+    const void *p = section(name, bytes);
+    return SectionIn(name, p, bytes);
+  }
+
+private:
+  static void copyOut(const std::string &name, const void *src, size_t bytes,
+                      void *dst, size_t expect);
+  std::string path;
+  const char *base;
+  size_t length;
+  const CkptSectionEntry *entries;
+  uint32_t num_sections;
+};
+
+} // namespace GNN
+
+#endif // GNN_COMMON_SERIALIZE_H_
@@ -0,0 +1,106 @@
+#ifndef GNN_COMMON_TRANS_TABLE_H_
+#define GNN_COMMON_TRANS_TABLE_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "common/serialize.h"
+
+namespace GNN {
+
+// MSHR 风格的定长事务表：以小整数事务号索引，分配/释放 O(1)，构造后不再分配内存。
+// 事务号随 DataPacket 传递（setTransId），完成时按事务号直接找回表项，
+// 不再按地址查哈希表。分配序号单调递增，用于同地址事务的先后判定
+template <typename T> class TransTable {
+public:
+  static constexpr int kInvalid = -1;
+
+  explicit TransTable(size_t capacity = 0) { resize(capacity); }
+
+  // 仅在表空时调整容量
+  void resize(size_t capacity) {
+    assert(_size == 0);
+    slots.assign(capacity, T());
+    seqs.assign(capacity, 0);
+    freeIds.clear();
+    freeIds.reserve(capacity);
+    for (size_t i = capacity; i-- > 0;)
+      freeIds.push_back(static_cast<int>(i));
+  }
+
+  size_t capacity() const { return slots.size(); }
+  size_t size() const { return _size; }
+  bool empty() const { return _size == 0; }
+  bool full() const { return freeIds.empty(); }
+
+  // 表满时返回 kInvalid，由调用方反压
+  int alloc(const T &v) {
+    if (freeIds.empty())
+      return kInvalid;
+    int id = freeIds.back();
+    freeIds.pop_back();
+    slots[id] = v;
+    seqs[id] = ++nextSeq;
+    ++_size;
+    return id;
+  }
+
+  void free(int id) {
+    assert(valid(id));
+    seqs[id] = 0;
+    freeIds.push_back(id);
+    --_size;
+  }
+
+  bool valid(int id) const {
+    return id >= 0 && static_cast<size_t>(id) < slots.size() && seqs[id] != 0;
+  }
+  T &operator[](int id) {
+    assert(valid(id));
+    return slots[id];
+  }
+  const T &operator[](int id) const {
+    assert(valid(id));
+    return slots[id];
+  }
+  uint64_t seq(int id) const { return seqs[id]; }
+
+  // 在有效表项中找满足条件且分配最早的一项，未找到返回 kInvalid。
+  // 表项数很少（DRAM 队列深度量级），顺序扫描连续数组即可
+  template <typename Pred> int findOldest(Pred pred) const {
+    int best = kInvalid;
+    for (size_t i = 0; i < slots.size(); ++i) {
+      if (seqs[i] != 0 && pred(slots[i]) &&
+          (best == kInvalid || seqs[i] < seqs[best]))
+        best = static_cast<int>(i);
+    }
+    return best;
+  }
+
+  // 检查点只在排空后保存，表必为空：空闲号的次序和分配序号决定之后的分配结果
+  void serialize(SectionOut &os) const {
+    assert(empty());
+    os.put(freeIds);
+    os.put(nextSeq);
+  }
+  void unserialize(SectionIn &is) {
+    assert(empty());
+    is.get(freeIds);
+    is.get(nextSeq);
+    if (freeIds.size() != slots.size())
+      throw std::runtime_error("checkpoint transaction table capacity mismatch");
+  }
+
+private:
+  std::vector<T> slots;
+  std::vector<uint64_t> seqs; // 0 表示空闲
+  std::vector<int> freeIds;
+  size_t _size = 0;
+  uint64_t nextSeq = 0;
+};
+
+} // namespace GNN
+
+#endif // GNN_COMMON_TRANS_TABLE_H_
@@ -1,4 +1,6 @@
 #include "compute/ComputeModule.h"
+#include "common/serialize.h"
+#include <cassert>
 
 namespace GNN
 {
@@ -42,6 +44,27 @@ namespace GNN
         return output_per_bank_;
     }
 
+    void ComputeModule::serialize(SectionOut &os) const
+    {
+        assert(!pending_resp_);
+        os.put(A_);
+        os.put(N_);
+        os.put(processed_chunks_per_bank_);
+        os.put(output_per_bank_);
+        os.put(pending_request_);
+        os.put(in_flight_);
+    }
+
+    void ComputeModule::unserialize(SectionIn &is)
+    {
+        is.get(A_);
+        is.get(N_);
+        is.get(processed_chunks_per_bank_);
+        is.get(output_per_bank_);
+        is.get(pending_request_);
+        is.get(in_flight_);
+    }
+
     void ComputeModule::scheduleRequestIfNeeded(uint32_t delay)
     {
         if (!requestEvent.scheduled())
@@ -133,7 +156,7 @@ namespace GNN
         pending_request_[bank_id] = true;
         scheduleRequestIfNeeded(32);
 
-        delete pkt;
+        PacketManager::free_packet(pkt);
         return true;
     }
 
@@ -176,7 +199,7 @@ namespace GNN
         }
 
         // consume the request packet
-        delete pkt;
+        PacketManager::free_packet(pkt);
         return true;
     }
 
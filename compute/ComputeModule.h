@@ -28,6 +28,9 @@ public:
     // 读取最近一次计算的每列输出
     const std::vector<long long> &getOutputs() const;
 
+    void serialize(SectionOut &os) const override;
+    void unserialize(SectionIn &is) override;
+
 private:
     int active_banks_;
     std::vector<int32_t> A_;
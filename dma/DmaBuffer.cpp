@@ -4,17 +4,18 @@
 #include "../common/object.h"
 #include "../common/packet.h"
 #include "../common/port.h"
+#include "../dram/addr_map.h"
 #include "../event/eventq.h"
 #include <algorithm>  // for std::min
 #include <cassert>
 #include <deque>
 #include <functional>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
 namespace GNN
 {
-  constexpr int      DmaBuffer::num_ports;
   constexpr uint32_t DmaBuffer::addr_stride;
 
   DmaBuffer::DmaBuffer(const std::string& name,
@@ -25,48 +26,105 @@ namespace GNN
                        uint32_t           total_inst_num_cfg,
                        const std::string& data_file_base_path,
                        const std::string& data_file_suffix)
-    : SimObject(name), FileReader(total_slice_num_cfg, total_inst_num_cfg), base_addr_(base_addr), burst_num_(burst_num), active_banks_(active_banks),
-      addr_stride_(active_banks * addr_stride), sendRespondEvent([this] { sendRespond(); }, name + ".sendRespondEvent"),
-      tickEvent([this] { tick(); }, name + ".tickEvent")
+    : ClockedObject(name), FileReader(total_slice_num_cfg, total_inst_num_cfg), base_addr_(base_addr), burst_num_(burst_num), active_banks_(active_banks),
+      addr_stride_(active_banks * addr_stride), sendRespondEvent(*this, "sendRespondEvent"),
+      tickEvent(*this, "tickEvent")
   {
+    setTickEvent(tickEvent);
     setDataFilePathTemplate(data_file_base_path, data_file_suffix);
-    requestPorts.reserve(num_ports);
-    req_fifos_.resize(num_ports);
-    for (int i = 0; i < num_ports; ++i)
+    assert(active_banks_ > 0);
+    requestPorts.reserve(active_banks_);
+    req_fifos_.resize(active_banks_);
+    for (int i = 0; i < active_banks_; ++i)
     {
-      current_buf_idx_[i] = true;
       requestPorts.emplace_back(name + "dma_side" + std::to_string(i), *this, i);
     }
     // 构造计算侧端口与队列
-    computePorts.reserve(num_ports);
-    compute_resp_fifos_.resize(num_ports);
-    for (int i = 0; i < num_ports; ++i)
+    computePorts.reserve(active_banks_);
+    compute_resp_fifos_.resize(active_banks_);
+    for (int i = 0; i < active_banks_; ++i)
     {
       computePorts.emplace_back(name + "comp_side" + std::to_string(i), *this, i);
     }
 
-    bank_controllers_.resize(active_banks_);
-    for (int i = 0; i < active_banks_; ++i)
-    {
-      bank_controllers_[i].buffers[0].dma_pkt.reserve(burst_num_);
-      bank_controllers_[i].buffers[1].dma_pkt.reserve(burst_num_);
-    }
-    for (int i = 0; i < active_banks_; ++i)
-    {
-      req_pkt_[i]           = nullptr;
-      request_retryReq[i]   = false;
-      response_retryResp[i] = false;
-      response_retryReq[i]  = false;
-      request_retryResp[i]  = false;
-      recv_req_send_resp[i] = false;
-      next_read_idx_[i]     = 0;
-    }
+    bank_rd_addr_.assign(active_banks_, 0);
+    bank_transfer_active_.assign(active_banks_, false);
+    req_pkt_.assign(active_banks_, nullptr);
+    request_retryReq.assign(active_banks_, false);
+    response_retryResp.assign(active_banks_, false);
+    response_retryReq.assign(active_banks_, false);
+    request_retryResp.assign(active_banks_, false);
+    recv_req_send_resp.assign(active_banks_, false);
     // === 新增 per-bank 状态 ===
     cmd_queues_.resize(active_banks_);
     current_cmds_.resize(active_banks_);
     inst_cnts_.resize(active_banks_, 0);
     trans_states_.resize(active_banks_, IDLE);
     lines_fetched_for_cmds_.resize(active_banks_, 0);
+    cmd_segments_.resize(active_banks_);
+    cmd_lines_.resize(active_banks_, 0);
+    seg_idx_.resize(active_banks_, 0);
+    seg_left_.resize(active_banks_, 0);
+    streams_.resize(active_banks_);
+    issue_stats_.resize(active_banks_);
+    allocBuffers();
+  }
+
+  void DmaBuffer::allocBuffers()
+  {
+    bank_controllers_.assign(active_banks_, BankController());
+    for (auto& controller : bank_controllers_)
+    {
+      controller.buffers.resize(buffer_depth_);
+      for (auto& buf : controller.buffers)
+        buf.dma_pkt.reserve(burst_num_);
+      controller.ranges.assign(buffer_depth_, {});
+      controller.stalled.assign(buffer_depth_, false);
+    }
+    // 首条命令在 CONFIG 中前移到 0 号buf
+    current_buf_idx_.assign(active_banks_, buffer_depth_ - 1);
+    next_read_idx_.assign(active_banks_, 0);
+    buf_cmd_id_.assign(active_banks_, std::vector<uint64_t>(buffer_depth_, 0));
+    buf_cmd_callback_.assign(active_banks_, std::vector<std::function<void(uint64_t)>>(buffer_depth_));
+    occupancy_.assign(active_banks_, BufferOccupancy());
+    for (auto& occ : occupancy_)
+      occ.used_ticks.assign(buffer_depth_ + 1, 0);
+  }
+
+  void DmaBuffer::setBufferDepth(int depth)
+  {
+    assert(depth > 0);
+    // 只能在尚未开始搬运时改变深度
+    for (int bank = 0; bank < active_banks_; ++bank)
+      assert(inst_cnts_[bank] == 0 && trans_states_[bank] == IDLE && cmd_queues_[bank].empty());
+    buffer_depth_ = depth;
+    allocBuffers();
+  }
+
+  void DmaBuffer::setIssueWidth(int width)
+  {
+    assert(width > 0);
+    issue_width_ = width;
+  }
+
+  int DmaBuffer::DmaCommand::flatten(std::vector<DmaSegment>& out) const
+  {
+    out.clear();
+    int lines = 0;
+    for (const DmaCommand* cmd = this; cmd; cmd = cmd->next.get())
+    {
+      if (!cmd->segments.empty())
+        out.insert(out.end(), cmd->segments.begin(), cmd->segments.end());
+      else
+        for (int r = 0; r < cmd->rows; ++r)
+          out.push_back({ cmd->base_addr + static_cast<addr_t>(r) * cmd->row_stride, cmd->total_lines });
+    }
+    // 空段不占槽位，直接去掉
+    out.erase(std::remove_if(out.begin(), out.end(), [](const DmaSegment& seg) { return seg.lines <= 0; }),
+              out.end());
+    for (const DmaSegment& seg : out)
+      lines += seg.lines;
+    return lines;
   }
 
   // DmaRequestPort inner class implementation
@@ -82,6 +140,13 @@ namespace GNN
     owner.sendRetryReq(port_id);
   }
 
+  void DmaBuffer::DmaRequestPort::recvCredit()
+  {
+    // 信用流控：只有因缺信用而暂停的端口需要唤醒
+    if (owner.request_retryReq[port_id])
+      owner.sendRetryReq(port_id);
+  }
+
   // ComputeSidePort implementation
   DmaBuffer::ComputeSidePort::ComputeSidePort(const std::string& name, DmaBuffer& o, int id): ResponsePort(name), owner(o), bank_id(id)
   {
@@ -96,6 +161,9 @@ namespace GNN
 
   bool DmaBuffer::recvTimingReq(PacketPtr pkt, uint32_t bank_id)
   {
+    // 功能模式下按需取数，存储侧不会让请求等待
+    if (isFunctional())
+      fetchFunctional(bank_id);
 
     int idx = getReadableBufferIndex(bank_id);
     if (idx < 0)
@@ -121,88 +189,6 @@ namespace GNN
     }
     return true;
   }
-  void DmaBuffer::sendRespond()
-  {
-    // 构造响应包，搬运该FULL缓冲数据
-    for (int bank = 0; bank < active_banks_; bank++)
-    {
-      //   assert(!response_retryResp[bank]);
-      if (!response_retryResp[bank] && recv_req_send_resp[bank])
-      {
-        int idx = getReadableBufferIndex(bank);
-        if (idx < 0)
-          continue;
-        assert(!bank_controllers_[bank].buffers[idx].dma_pkt.empty());
-        auto& dq = bank_controllers_[bank].buffers[idx].dma_pkt;
-
-        // D_INFO("DMA", "[DMA]dq.size()：%d,addr:%d", dq.size(),
-        // dq.front()->getAddr()); D_INFO("DMA", "[DMA]dq.size()：%d,addr:%d",
-        // dq.size(), dq.back()->getAddr());
-        int batch = std::min(static_cast<int>(dq.size()), BURST_NUM);
-
-        // 将前 batch 个包合并成一个包（复用第一个包作为合并后的承载）
-        PacketPtr _pkt = dq.front();
-        if (batch > 1)
-        {
-          std::vector<storage_t> merged = _pkt->getData();
-          merged.reserve(merged.size() + 1024);  // 预留一些空间，避免多次扩容
-          size_t total_size = _pkt->getSize();
-          for (int i = 1; i < batch; ++i)
-          {
-            PacketPtr   p = dq[i];
-            const auto& d = p->getData();
-            if (!d.empty())
-              merged.insert(merged.end(), d.begin(), d.end());
-            total_size += p->getSize();
-          }
-          _pkt->setData(merged);
-          _pkt->setSize(total_size);
-        }
-
-        _pkt->setBankId(bank);
-        _pkt->setBufferIdx(idx);
-        // 直接尝试发送响应
-        bool success = computePorts[bank].sendTimingResp(_pkt);
-        if (success)
-        {
-          recv_req_send_resp[bank] = false;
-          // 注意：不要释放发送给下游的packet，应该由下游负责释放
-          // PacketManager::free_packet(req_pkt_[bank]);
-          // req_pkt_[bank] = nullptr;
-
-          // 释放数据包
-          if (batch <= 1)
-          {
-            dq.erase(dq.begin());
-          }
-          else
-          {
-            // 保留第一个（被复用发送的）不释放，由下游负责释放
-            dq.erase(dq.begin());
-            for (int i = 1; i < batch; ++i)
-            {
-              PacketManager::free_packet(dq.front());
-              dq.erase(dq.begin());
-            }
-          }
-          if (dq.empty())
-            releaseBankBuffer(bank, idx);
-          else
-          {
-            if (!sendRespondEvent.scheduled())
-              schedule(sendRespondEvent, curTick() + 1);
-          }
-        }
-        else
-        {
-          // 对端暂时无法接收，排入响应队列，等待对端resp retry
-          D_INFO("DMA", "响应发送失败: bank=%d", bank);
-          compute_resp_fifos_[bank].push_back(_pkt);
-          response_retryResp[bank] = true;
-        }
-      }
-    }
-  }
   void DmaBuffer::ComputeSidePort::recvRespRetry()
   {
     // 对端可以再次接收响应，尝试发送队列中的响应
@@ -213,8 +199,10 @@ namespace GNN
       if (sendTimingResp(pkt))
       {
         q.pop_front();
-        // 发送成功后释放对应缓冲
+        // 发送成功后释放对应缓冲；下游请求已应答，归还请求包
         D_INFO("DMA", "释放缓冲: bank=%d, idx=%d", bank_id, pkt->getBufferIdx());
+        PacketManager::free_packet(owner.req_pkt_[bank_id]);
+        owner.req_pkt_[bank_id] = nullptr;
         owner.releaseBankBuffer(bank_id, pkt->getBufferIdx());
         owner.response_retryResp[bank_id] = false;
       }
@@ -225,6 +213,32 @@ namespace GNN
   {
   }
 
+  void DmaBuffer::memoryModeChanged()
+  {
+    // 功能阶段 tick 休眠且只按需取数，切回时序时可能还有未取完的命令
+    if (!isFunctional())
+      schedule_tick_if_needed();
+  }
+
+  void DmaBuffer::releasePackets()
+  {
+    for (int bank = 0; bank < active_banks_; ++bank)
+    {
+      for (auto& buf : bank_controllers_[bank].buffers)
+        buf.reset(burst_num_);
+      for (PacketPtr pkt : req_fifos_[bank])
+        PacketManager::free_packet(pkt);
+      req_fifos_[bank].clear();
+      // 权重/特征库应答的就是请求包本身，同一个包只归还一次
+      for (PacketPtr pkt : compute_resp_fifos_[bank])
+        if (pkt != req_pkt_[bank])
+          PacketManager::free_packet(pkt);
+      compute_resp_fifos_[bank].clear();
+      PacketManager::free_packet(req_pkt_[bank]);
+      req_pkt_[bank] = nullptr;
+    }
+  }
+
   void DmaBuffer::enqueueCommand(const DmaCommand& cmd)
   {
     int bank = cmd.bank_id;
@@ -233,131 +247,261 @@ namespace GNN
       D_INFO("DMA", "enqueueCommand: invalid bank_id=%d", bank);
       return;
     }
-    // 检查是否还能接受新指令：每个bank两个buf进行双缓冲，最多只能有2条活跃指令
-    if (inst_cnts_[bank] >= 2)
+    // 描述符超出一个缓冲是调用方的错误：子类已为它分配了命令号，丢弃会让消费方永远等不到这条数据
+    std::vector<DmaSegment> segs;
+    int                     lines = cmd.flatten(segs);
+    if (lines <= 0 || lines > burst_num_)
+      D_ERROR("DMA", "Command %lu: %d lines does not fit buffer of %d", cmd.cmd_id, lines, burst_num_);
+    assert(lines > 0 && lines <= burst_num_);
+    // recvTimingResp 按第一个命中的段定位槽位，段间有重叠或重复时后面的段永远填不满
+    std::vector<std::pair<addr_t, addr_t>> spans;
+    for (const DmaSegment& seg : segs)
+    {
+      addr_t first = AddrInterleave::firstLine(seg.base_addr, bank, active_banks_);
+      spans.push_back({ first, first + static_cast<addr_t>(seg.lines - 1) * addr_stride_ });
+    }
+    std::sort(spans.begin(), spans.end());
+    bool disjoint = true;
+    for (size_t i = 1; i < spans.size(); ++i)
+      disjoint = disjoint && spans[i].first > spans[i - 1].second;
+    if (!disjoint)
+      D_ERROR("DMA", "Command %lu: segments overlap on bank %d", cmd.cmd_id, bank);
+    assert(disjoint);
+    // 检查是否还能接受新指令：每条活跃指令独占一个buf，最多 buffer_depth_ 条
+    if (inst_cnts_[bank] >= buffer_depth_)
     {
       D_INFO("DMA",
-             "Command %lu rejected: bank %d already has %d instructions (max 2 "
-             "for dual buffer)",
+             "Command %lu rejected: bank %d already has %d instructions (max %d)",
              cmd.cmd_id,
              bank,
-             inst_cnts_[bank]);
+             inst_cnts_[bank],
+             buffer_depth_);
       return;
     }
     cmd_queues_[bank].push_back(cmd);
+    streams_[bank].train(cmd.base_addr, cmd.linear() ? lines : 0);
     D_INFO("DMA", "Command %lu enqueued to bank %d. Current inst_cnt: %d", cmd.cmd_id, bank, inst_cnts_[bank]);
     schedule_tick_if_needed();
   }
 
-  void DmaBuffer::tick()
+  void DmaBuffer::advanceBank(int bank)
   {
-    // 全部bank独立推进自己的DMA状态机
-    for (int bank = 0; bank < active_banks_; ++bank)
+    // 1. 状态机驱动核心逻辑
+    if (trans_states_[bank] == IDLE)
     {
-      // 1. 状态机驱动核心逻辑
-      if (trans_states_[bank] == IDLE)
+      if (inst_cnts_[bank] < buffer_depth_ && !cmd_queues_[bank].empty())
       {
-        if (inst_cnts_[bank] < 2 && !cmd_queues_[bank].empty())
-        {
-          // 获取新命令
-          current_cmds_[bank] = cmd_queues_[bank].front();
-          cmd_queues_[bank].pop_front();
-          lines_fetched_for_cmds_[bank] = 0;
-          trans_states_[bank]           = CONFIG;
-          D_INFO("DMA",
-                 "[bank%d] Starting command %lu: base_addr=%#d, lines=%d, "
-                 "inst_cnt will be %d",
-                 bank,
-                 current_cmds_[bank].cmd_id,
-                 current_cmds_[bank].base_addr,
-                 current_cmds_[bank].total_lines,
-                 inst_cnts_[bank] + 1);
-        }
+        // 获取新命令
+        current_cmds_[bank] = cmd_queues_[bank].front();
+        cmd_queues_[bank].pop_front();
+        lines_fetched_for_cmds_[bank] = 0;
+        trans_states_[bank]           = CONFIG;
+        D_INFO("DMA",
+               "[bank%d] Starting command %lu: base_addr=%#x, lines=%d, "
+               "inst_cnt will be %d",
+               bank,
+               current_cmds_[bank].cmd_id,
+               current_cmds_[bank].base_addr,
+               current_cmds_[bank].total_lines,
+               inst_cnts_[bank] + 1);
       }
-      if (trans_states_[bank] == CONFIG)
+    }
+    if (trans_states_[bank] == CONFIG)
+    {
+      noteOccupancy(bank);
+      inst_cnts_[bank]++;
+      // 每bank在自己的缓冲环上前移一格；活跃指令数受限于深度，该buf必已释放
+      current_buf_idx_[bank] = (current_buf_idx_[bank] + 1) % buffer_depth_;
+      auto& segs             = cmd_segments_[bank];
+      cmd_lines_[bank]       = current_cmds_[bank].flatten(segs);
+      seg_idx_[bank]         = 0;
+      seg_left_[bank]        = segs.front().lines;
+      // 逻辑地址按行在通道间交织，取 base_addr 之后第一个属于本 bank 通道的行
+      bank_rd_addr_[bank]    = AddrInterleave::firstLine(segs.front().base_addr, bank, active_banks_);
+      auto& controller       = bank_controllers_[bank];
+      int   write_idx        = current_buf_idx_[bank];
+      if (controller.buffers[write_idx].state == BufferState::FILLING)
       {
-        inst_cnts_[bank]++;
-        // 每bank切换自己的buf索引
-        current_buf_idx_[bank] = 1 - current_buf_idx_[bank];  // 保持原双缓冲互斥，若需bank粒度再拆
-        int    ori_ch          = (current_cmds_[bank].base_addr % 0x100) / 0x40;
-        addr_t dram_bias_addr  = bank >= ori_ch ? (bank - ori_ch) * addr_stride : (bank - ori_ch + active_banks_) * addr_stride;
-        bank_rd_addr_[bank]    = current_cmds_[bank].base_addr + dram_bias_addr;
-        auto& controller       = bank_controllers_[bank];
-        int   write_idx        = current_buf_idx_[bank];
-        if (controller.buffers[write_idx].state == BufferState::FILLING)
+        // 各段依次占用缓冲中的连续槽位
+        auto& ranges = controller.ranges[write_idx];
+        ranges.clear();
+        int slot = 0;
+        for (const DmaSegment& seg : segs)
         {
-          controller.dram_base_addr[write_idx]        = bank_rd_addr_[bank];
-          controller.dram_final_addr[write_idx]       = bank_rd_addr_[bank] + static_cast<addr_t>(current_cmds_[bank].total_lines) * addr_stride_;
-          controller.buffers[write_idx].state         = BufferState::FILLING;
-          controller.buffers[write_idx].words_written = 0;
-          controller.buffers[write_idx].dma_pkt.clear();
-          controller.buffers[write_idx].dma_pkt.reserve(burst_num_);
-          bank_transfer_active_[bank]   = true;
-          controller.stalled[write_idx] = false;
-          D_INFO("DMA",
-                 "[bank%d] Starting command %lu: dram_base_addr=%#d, lines=%d, "
-                 "inst_cnt %d, dram_final_addr=%#d",
-                 bank,
-                 current_cmds_[bank].cmd_id,
-                 controller.dram_base_addr[write_idx],
-                 current_cmds_[bank].total_lines,
-                 inst_cnts_[bank],
-                 controller.dram_final_addr[write_idx]);
-          buf_cmd_id_[bank][write_idx]       = current_cmds_[bank].cmd_id;
-          buf_cmd_callback_[bank][write_idx] = current_cmds_[bank].completion_callback;
+          addr_t first = AddrInterleave::firstLine(seg.base_addr, bank, active_banks_);
+          ranges.push_back({ first, first + static_cast<addr_t>(seg.lines - 1) * addr_stride_, slot });
+          slot += seg.lines;
         }
-        trans_states_[bank] = STREAMING;
+        // 2D 命令可展开成上千段，按起始地址排序后响应用二分查找定位
+        if (!std::is_sorted(ranges.begin(), ranges.end(),
+                            [](const BufferRange& a, const BufferRange& b) { return a.first < b.first; }))
+          std::sort(ranges.begin(), ranges.end(),
+                    [](const BufferRange& a, const BufferRange& b) { return a.first < b.first; });
+        controller.buffers[write_idx].state         = BufferState::FILLING;
+        controller.buffers[write_idx].words_written = 0;
+        controller.buffers[write_idx].reset(burst_num_);
+        controller.buffers[write_idx].pkt_num       = cmd_lines_[bank];
+        bank_transfer_active_[bank]   = true;
+        controller.stalled[write_idx] = false;
+        D_INFO("DMA",
+               "[bank%d] Starting command %lu: dram_base_addr=%#x, lines=%d, "
+               "segments=%d, inst_cnt %d",
+               bank,
+               current_cmds_[bank].cmd_id,
+               ranges.front().first,
+               cmd_lines_[bank],
+               static_cast<int>(segs.size()),
+               inst_cnts_[bank]);
+        buf_cmd_id_[bank][write_idx]       = current_cmds_[bank].cmd_id;
+        buf_cmd_callback_[bank][write_idx] = current_cmds_[bank].completion_callback;
       }
-      if (trans_states_[bank] == STREAMING)
+      trans_states_[bank] = STREAMING;
+    }
+    if (trans_states_[bank] == STREAMING)
+    {
+      if (lines_fetched_for_cmds_[bank] >= cmd_lines_[bank])
       {
-        if (lines_fetched_for_cmds_[bank] >= current_cmds_[bank].total_lines)
+        trans_states_[bank] = IDLE;
+        // 顺序流在同一周期配置并发出下一条已排队命令的首行
+        if (stream_detect_ && streams_[bank].confirmed() && !cmd_queues_[bank].empty())
         {
-          trans_states_[bank] = IDLE;
+          advanceBank(bank);
+          if (trans_states_[bank] != IDLE)
+            streams_[bank].chained++;
         }
-        else
+      }
+      else
+      {
+        if (bank_transfer_active_[bank] && !bank_controllers_[bank].stalled[current_buf_idx_[bank]])
         {
-          if (bank_transfer_active_[bank] && !bank_controllers_[bank].stalled[current_buf_idx_[bank]])
+          PacketPtr read_pkt = PacketManager::create_read_packet(bank_rd_addr_[bank], BURST_BITS / STORAGE_SIZE);
+          if (isFunctional())
           {
-            PacketPtr read_pkt = PacketManager::create_read_packet(bank_rd_addr_[bank], BURST_BITS / STORAGE_SIZE);
+            // 功能模式：经 DramArb/DRAMsim3 即时取回，直接写入缓冲
+            requestPorts[bank].sendFunctional(read_pkt);
+            bool filled = recvTimingResp(read_pkt, bank);
+            assert(filled);
+            (void)filled;
+          }
+          else
             req_fifos_[bank].push_back(read_pkt);
-            addr_t final_addr_for_cmd = current_cmds_[bank].base_addr + static_cast<addr_t>(current_cmds_[bank].total_lines) * addr_stride_;
-            D_INFO("DMA",
-                   "[bank%d] bank_rd_addr_=%#d, final_addr_for_cmd=%#d, "
-                   "lines_fetched_for_cmd_=%d",
-                   bank,
-                   bank_rd_addr_[bank],
-                   final_addr_for_cmd,
-                   lines_fetched_for_cmds_[bank]);
-            bank_rd_addr_[bank] += addr_stride_;
-            if (bank_rd_addr_[bank] >= final_addr_for_cmd)
+          D_INFO("DMA",
+                 "[bank%d] bank_rd_addr_=%#x, segment=%d, "
+                 "lines_fetched_for_cmd_=%d",
+                 bank,
+                 bank_rd_addr_[bank],
+                 static_cast<int>(seg_idx_[bank]),
+                 lines_fetched_for_cmds_[bank]);
+          bank_rd_addr_[bank] += addr_stride_;
+          // 一段取完直接接下一段，段间不回到 CONFIG
+          if (--seg_left_[bank] == 0)
+          {
+            const auto& segs = cmd_segments_[bank];
+            if (++seg_idx_[bank] < segs.size())
             {
-              bank_transfer_active_[bank] = false;
+              seg_left_[bank]     = segs[seg_idx_[bank]].lines;
+              bank_rd_addr_[bank] = AddrInterleave::firstLine(segs[seg_idx_[bank]].base_addr, bank, active_banks_);
             }
+            else
+              bank_transfer_active_[bank] = false;
           }
-          lines_fetched_for_cmds_[bank]++;
         }
+        lines_fetched_for_cmds_[bank]++;
       }
     }
-    // 2. 依然保留向所有bank发请求的全局循环
-    for (int i = 0; i < num_ports; ++i)
+  }
+
+  void DmaBuffer::fetchFunctional(int bank)
+  {
+    // 时序阶段生成但尚未发出的读请求改为即时取回，不再经仲裁器排队
+    auto& fifo = req_fifos_[bank];
+    while (!fifo.empty())
+    {
+      PacketPtr pkt = fifo.front();
+      fifo.pop_front();
+      requestPorts[bank].sendFunctional(pkt);
+      bool filled = recvTimingResp(pkt, bank);
+      assert(filled);
+      (void)filled;
+    }
+    // 存储即时应答，按需推进状态机直到有一个可读缓冲，不把缓冲环一次填满；
+    // 中途切回时序时缓冲占用接近逐周期仿真的稳态
+    while (getReadableBufferIndex(bank) < 0)
+    {
+      TransState state   = trans_states_[bank];
+      int        fetched = lines_fetched_for_cmds_[bank];
+      size_t     queued  = cmd_queues_[bank].size();
+      advanceBank(bank);
+      if (state == trans_states_[bank] && fetched == lines_fetched_for_cmds_[bank] &&
+          queued == cmd_queues_[bank].size())
+        break;
+    }
+  }
+
+  void DmaBuffer::tick()
+  {
+    // 全部bank独立推进自己的DMA状态机，每周期最多生成 issue_width_ 个读请求
+    for (int bank = 0; bank < active_banks_; ++bank)
+    {
+      if (isFunctional())
+      {
+        fetchFunctional(bank);
+        continue;
+      }
+      for (int n = 0; n < issue_width_; ++n)
+      {
+        TransState state   = trans_states_[bank];
+        int        fetched = lines_fetched_for_cmds_[bank];
+        advanceBank(bank);
+        if (state == trans_states_[bank] && fetched == lines_fetched_for_cmds_[bank])
+          break;
+      }
+    }
+    // 功能模式下没有要发出的请求，取数由请求/入队/释放缓冲按需驱动，tick 无需逐周期轮询
+    if (isFunctional())
+    {
+      if (!tickEvent.scheduled() && !sleep())
+        schedule(tickEvent, curTick() + 1);
+      return;
+    }
+    // 2. 依然保留向所有bank发请求的全局循环：每bank最多发 issue_width_ 个，被拒即停
+    for (int i = 0; i < active_banks_; ++i)
     {
-      if (!req_fifos_[i].empty())
+      auto& stats  = issue_stats_[i];
+      bool  active = !req_fifos_[i].empty() || trans_states_[i] == STREAMING;
+      bool  waited = request_retryReq[i];
+      int   sent   = 0;
+      while (sent < issue_width_ && !req_fifos_[i].empty())
       {
         PacketPtr pkt = req_fifos_[i].front();
-        if (!request_retryReq[i] && requestPorts[i].sendTimingReq(pkt))
+        if (!request_retryReq[i] && requestPorts[i].hasCredit() &&
+            requestPorts[i].sendTimingReq(pkt))
         {
           req_fifos_[i].pop_front();
+          sent++;
         }
         else
+        {
+          if (!request_retryReq[i])
+            stats.blocked_since = curTick();
           request_retryReq[i] = true;
+          break;
+        }
+      }
+      stats.issued += sent;
+      // 被拒的周期计入 blocked（由重试时刻结算），其余活跃周期按是否发满归类
+      if (active && !waited && !request_retryReq[i])
+      {
+        stats.active++;
+        if (sent == issue_width_)
+          stats.full++;
+        else
+          stats.starved++;
       }
     }
-    // 3. 继续调度判据（此处取任一bank尚有活跃命令即可）
-    bool active_cmd = false;
-    for (int bank = 0; bank < active_banks_; ++bank)
-      if (trans_states_[bank] != IDLE || !cmd_queues_[bank].empty() || !request_retryReq[bank])
-        active_cmd = true;
-    if (active_cmd)
+    // 3. 继续调度判据：所有bank都在等重试时停止，由 sendRetryReq 重新调度；
+    //    其余静止周期休眠，由入队命令/重试/释放缓冲唤醒
+    if (!waitingRetryOnly() && (!quiescent() || !sleep()))
     {
       D_INFO("DMA", "Tick....");
       if (!tickEvent.scheduled())
@@ -367,6 +511,26 @@ namespace GNN
     }
   }
 
+  bool DmaBuffer::waitingRetryOnly() const
+  {
+    for (int bank = 0; bank < active_banks_; ++bank)
+      if (trans_states_[bank] != IDLE || !cmd_queues_[bank].empty() || !request_retryReq[bank])
+        return false;
+    return true;
+  }
+
+  bool DmaBuffer::quiescent() const
+  {
+    // 队首命令只在等缓冲释放时不需要逐周期检查，释放缓冲会唤醒
+    for (int bank = 0; bank < active_banks_; ++bank)
+      if (trans_states_[bank] != IDLE || (!cmd_queues_[bank].empty() && inst_cnts_[bank] < buffer_depth_))
+        return false;
+    for (int i = 0; i < active_banks_; ++i)
+      if (!req_fifos_[i].empty() && !request_retryReq[i])
+        return false;
+    return true;
+  }
+
   bool DmaBuffer::recvTimingResp(PacketPtr pkt, int port_id)
   {
     if (pkt->isRead())
@@ -374,14 +538,21 @@ namespace GNN
       auto&  controller = bank_controllers_[port_id];
       addr_t pkt_addr   = pkt->getAddr();
 
-      // 根据地址区间判断数据属于哪个buf
+      // 根据地址区间判断数据属于哪个buf及其槽位
       int target_buf_idx = -1;
-      for (int buf_idx = 0; buf_idx < 2; ++buf_idx)
+      int idx            = 0;
+      for (int buf_idx = 0; buf_idx < buffer_depth_ && target_buf_idx < 0; ++buf_idx)
       {
-        if (pkt_addr >= controller.dram_base_addr[buf_idx] && pkt_addr < controller.dram_final_addr[buf_idx])
+        const auto& ranges = controller.ranges[buf_idx];
+        auto        it     = std::upper_bound(ranges.begin(), ranges.end(), pkt_addr,
+                                   [](addr_t addr, const BufferRange& range) { return addr < range.first; });
+        if (it == ranges.begin())
+          continue;
+        const BufferRange& range = *--it;
+        if (pkt_addr <= range.last && (pkt_addr - range.first) % addr_stride_ == 0)
         {
           target_buf_idx = buf_idx;
-          break;
+          idx            = range.slot + static_cast<int>((pkt_addr - range.first) / addr_stride_);
         }
       }
 
@@ -392,15 +563,14 @@ namespace GNN
       }
 
       auto& buffer = controller.buffers[target_buf_idx];
-      D_INFO("DMA", "Bank %d 地址 %#d 路由到 buf %d, state: %d", port_id, pkt_addr, target_buf_idx, static_cast<int>(buffer.state));
+      D_INFO("DMA", "Bank %d 地址 %#x 路由到 buf %d, state: %d", port_id, pkt_addr, target_buf_idx, static_cast<int>(buffer.state));
 
       if (buffer.state == BufferState::FILLING)
       {
-        int idx = (pkt_addr - controller.dram_base_addr[target_buf_idx]) / addr_stride_;
         //     if(port_id ==2)
         //  D_INFO("CAM", "idx :%d, bank_id:%d,addr %d idx %d  size
         //  %d",target_buf_idx,port_id,pkt_addr, idx,buffer.dma_pkt.size());
-        assert(idx <= burst_num_);
+        assert(idx < static_cast<int>(buffer.pkt_num));
         assert(pkt != nullptr);
         if (idx >= static_cast<int>(buffer.dma_pkt.size()))
           buffer.dma_pkt.resize(idx + 1);
@@ -413,9 +583,12 @@ namespace GNN
         //  buffer.dma_pkt.size(), buffer.dma_pkt.back()->getAddr());
         buffer.words_written += 1;
         D_INFO("DMA", " buffer.words_written   %d", buffer.words_written);
-        if (buffer.words_written >= burst_num_)
+        if (buffer.words_written >= static_cast<int>(buffer.pkt_num))
         {
+          noteOccupancy(port_id);
           buffer.state = BufferState::FULL;
+          auto& occ    = occupancy_[port_id];
+          occ.max_full = std::max(occ.max_full, ++occ.full);
           // 使用该buf对应的命令ID，而不是当前命令ID
           D_INFO("DMA", "Bank %d Buffer %d is FULL for cmd %lu.", port_id, target_buf_idx, buf_cmd_id_[port_id][target_buf_idx]);
 
@@ -492,19 +665,20 @@ namespace GNN
 
   void DmaBuffer::releaseBankBuffer(int bank_id, int buffer_idx)
   {
-    assert(bank_id >= 0 && bank_id < active_banks_ && (buffer_idx == 0 || buffer_idx == 1));
+    assert(bank_id >= 0 && bank_id < active_banks_ && buffer_idx >= 0 && buffer_idx < buffer_depth_);
     auto& controller = bank_controllers_[bank_id];
 
     if (controller.buffers[buffer_idx].state == BufferState::FULL)
     {
+      noteOccupancy(bank_id);
+      occupancy_[bank_id].full--;
       controller.buffers[buffer_idx].state         = BufferState::FILLING;
       controller.buffers[buffer_idx].words_written = 0;
-      controller.buffers[buffer_idx].dma_pkt.clear();
-      controller.buffers[buffer_idx].dma_pkt.reserve(burst_num_);
+      controller.buffers[buffer_idx].reset(burst_num_);
 
       // D_INFO("DMA", "Bank %d Buffer %d released by consumer.", bank_id,
       // buffer_idx);
-      next_read_idx_[bank_id] = !next_read_idx_[bank_id];
+      next_read_idx_[bank_id] = (next_read_idx_[bank_id] + 1) % buffer_depth_;
 
       // 检查是否所有bank的指定buf都已被释放
       // bool all_specified_bufs_released = true;
@@ -541,35 +715,75 @@ namespace GNN
 
   int DmaBuffer::getReadableBufferIndex(int bank_id) const
   {
-    const auto& controller = bank_controllers_[bank_id];
-    bool        full0      = controller.buffers[current_buf_idx_[bank_id]].state == BufferState::FULL;
-    bool        full1      = controller.buffers[1 - current_buf_idx_[bank_id]].state == BufferState::FULL;
-    // D_INFO("DMA", "full0 : %d full1 : %d next_id :
-    // %d",static_cast<int>(full0),static_cast<int>(full1),next_read_idx_[bank_id]);
-    if (full0 || full1)
-      // 轮转选择，避免总是取同一侧
-      if (next_read_idx_[bank_id] == current_buf_idx_[bank_id] && full0)
-        return next_read_idx_[bank_id];
-      else if (next_read_idx_[bank_id] == 1 - current_buf_idx_[bank_id] && full1)
-        return next_read_idx_[bank_id];
+    // 按写入顺序读出：只有环上最早的buf已满才可读，后面先满的buf需等待
+    int idx = next_read_idx_[bank_id];
+    if (bank_controllers_[bank_id].buffers[idx].state == BufferState::FULL)
+      return idx;
     return -1;
   }
-  void DmaBuffer::sendRetryReq(int port_id)
+
+  void DmaBuffer::noteOccupancy(int bank)
   {
-    request_retryReq[port_id] = false;
-    schedule_tick_if_needed();
+    auto& occ = occupancy_[bank];
+    Tick  now = curTick();
+    occ.used_ticks[inst_cnts_[bank]] += now - occ.last;
+    occ.full_area += static_cast<Tick>(occ.full) * (now - occ.last);
+    occ.last = now;
   }
 
-  void DmaBuffer::schedule_tick_if_needed()
+  void DmaBuffer::printStats(std::ostream& os) const
   {
+    // 统计截止到当前时刻；单个buf容量为 burst_num_ 个逻辑行
+    Tick        now = curTick();
+    std::string tag = name().substr(0, name().find('.'));
+    os << "DmaBuffer " << tag << ": depth=" << buffer_depth_
+       << " buffer_bytes=" << static_cast<uint64_t>(burst_num_) * addr_stride
+       << " bank_bytes=" << static_cast<uint64_t>(burst_num_) * addr_stride * buffer_depth_ << std::endl;
     for (int bank = 0; bank < active_banks_; ++bank)
     {
-      if (!tickEvent.scheduled())
+      const auto& occ   = occupancy_[bank];
+      Tick        span  = std::max<Tick>(now, 1);
+      double      used  = 0;
+      for (int n = 0; n <= buffer_depth_; ++n)
       {
-        schedule(tickEvent, curTick() + 1);
+        Tick t = occ.used_ticks[n] + (n == inst_cnts_[bank] ? now - occ.last : 0);
+        used += double(n) * t;
+      }
+      Tick at_depth = occ.used_ticks[buffer_depth_] + (inst_cnts_[bank] == buffer_depth_ ? now - occ.last : 0);
+      double full   = double(occ.full_area + static_cast<Tick>(occ.full) * (now - occ.last));
+      os << "  bank" << bank << ": mean_used=" << used / span << " mean_full=" << full / span
+         << " max_full=" << occ.max_full << " at_depth=" << 100.0 * at_depth / span << "%";
+      if (stream_detect_)
+      {
+        const auto& stream = streams_[bank];
+        os << " stream=" << (stream.confirmed() ? "yes" : "no") << " stride=" << stream.stride
+           << " chained=" << stream.chained;
       }
+      os << std::endl;
+      // 发出速率：blocked 高说明受 DRAM 侧反压限制，starved 高说明 DMA 生成请求不够快，
+      // full 高说明发射宽度本身是瓶颈
+      const auto& is     = issue_stats_[bank];
+      Tick        cycles = is.active + is.blocked + (request_retryReq[bank] ? now - is.blocked_since : 0);
+      if (cycles > 0)
+        os << "    issue: width=" << issue_width_ << " issued=" << is.issued
+           << " rate=" << double(is.issued) / cycles << " full=" << 100.0 * is.full / cycles
+           << "% starved=" << 100.0 * is.starved / cycles << "% blocked="
+           << 100.0 * (cycles - is.active) / cycles << "%" << std::endl;
     }
   }
+  void DmaBuffer::sendRetryReq(int port_id)
+  {
+    if (request_retryReq[port_id])
+      issue_stats_[port_id].blocked += curTick() - issue_stats_[port_id].blocked_since;
+    request_retryReq[port_id] = false;
+    schedule_tick_if_needed();
+  }
+
+  void DmaBuffer::schedule_tick_if_needed()
+  {
+    if (!wake() && !tickEvent.scheduled())
+      schedule(tickEvent, curTick() + 1);
+  }
 
   Port& DmaBuffer::getPort(const std::string& if_name, int idx)
   {
@@ -577,19 +791,176 @@ namespace GNN
     // computePorts[idx].name().c_str());
     if (if_name.rfind(requestPorts[idx].name(), 0) == 0)
     {
-      int bank = std::stoi(if_name.substr(if_name.length() - 1));
-      if (bank >= 0 && bank < num_ports)
+      int bank = portIndexSuffix(if_name);
+      if (bank >= 0 && bank < active_banks_)
         return requestPorts[bank];
     }
     if (if_name.rfind(computePorts[idx].name(), 0) == 0)
     {
-      int bank = std::stoi(if_name.substr(if_name.length() - 1));
-      if (bank >= 0 && bank < num_ports)
+      int bank = portIndexSuffix(if_name);
+      if (bank >= 0 && bank < active_banks_)
         return computePorts[bank];
     }
     throw std::runtime_error("No such port: " + if_name);
   }
 
+  // 命令链按值展开保存
+  static void putCommand(SectionOut &os, const DmaBuffer::DmaCommand &cmd)
+  {
+    assert(!cmd.completion_callback);
+    os.put(cmd.bank_id);
+    os.put(cmd.base_addr);
+    os.put(cmd.total_lines);
+    os.put(cmd.cmd_id);
+    os.put(cmd.rows);
+    os.put(cmd.row_stride);
+    os.put(cmd.segments);
+    os.put(static_cast<bool>(cmd.next));
+    if (cmd.next)
+      putCommand(os, *cmd.next);
+  }
+
+  static void getCommand(SectionIn &is, DmaBuffer::DmaCommand &cmd)
+  {
+    is.get(cmd.bank_id);
+    is.get(cmd.base_addr);
+    is.get(cmd.total_lines);
+    is.get(cmd.cmd_id);
+    is.get(cmd.rows);
+    is.get(cmd.row_stride);
+    is.get(cmd.segments);
+    cmd.completion_callback = nullptr;
+    cmd.next.reset();
+    if (is.get<bool>())
+    {
+      auto next = std::make_shared<DmaBuffer::DmaCommand>();
+      getCommand(is, *next);
+      cmd.next = next;
+    }
+  }
+
+  void DmaBuffer::serialize(SectionOut &os) const
+  {
+    ClockedObject::serialize(os);
+    os.put(static_cast<int32_t>(active_banks_));
+    os.put(static_cast<int32_t>(buffer_depth_));
+    for (int bank = 0; bank < active_banks_; ++bank)
+    {
+      os.put(static_cast<uint64_t>(cmd_queues_[bank].size()));
+      for (const DmaCommand &cmd : cmd_queues_[bank])
+        putCommand(os, cmd);
+      putCommand(os, current_cmds_[bank]);
+
+      const BankController &ctrl = bank_controllers_[bank];
+      for (const BankBuffer &buf : ctrl.buffers)
+      {
+        // [0, read_pos) 已交给下游，只保存占位
+        os.put(static_cast<uint64_t>(buf.dma_pkt.size()));
+        for (size_t i = 0; i < buf.dma_pkt.size(); ++i)
+        {
+          PacketPtr pkt = i < buf.read_pos ? nullptr : buf.dma_pkt[i];
+          os.put(pkt);
+        }
+        os.put(static_cast<uint64_t>(buf.read_pos));
+        os.put(buf.pkt_num);
+        os.put(buf.state);
+        os.put(buf.words_written);
+      }
+      os.put(ctrl.ranges);
+      os.put(ctrl.current_write_idx);
+      os.put(ctrl.stalled);
+
+      for (const auto &callback : buf_cmd_callback_[bank])
+        assert(!callback);
+      // 解码侧总是立即接收应答，排空时不会有积压
+      assert(compute_resp_fifos_[bank].empty());
+
+      const BufferOccupancy &occ = occupancy_[bank];
+      os.put(occ.used_ticks);
+      os.put(occ.full_area);
+      os.put(occ.full);
+      os.put(occ.max_full);
+      os.put(occ.last);
+    }
+    os.put(inst_cnts_);
+    os.put(trans_states_);
+    os.put(lines_fetched_for_cmds_);
+    os.put(cmd_segments_);
+    os.put(cmd_lines_);
+    os.put(seg_idx_);
+    os.put(seg_left_);
+    os.put(bank_rd_addr_);
+    os.put(bank_transfer_active_);
+    os.put(current_buf_idx_);
+    os.put(buf_cmd_id_);
+    os.put(streams_);
+    os.put(issue_stats_);
+    os.put(req_fifos_);
+    os.put(req_pkt_);
+    os.put(response_retryReq);
+    os.put(response_retryResp);
+    os.put(recv_req_send_resp);
+    os.put(request_retryReq);
+    os.put(request_retryResp);
+    os.put(next_read_idx_);
+  }
+
+  void DmaBuffer::unserialize(SectionIn &is)
+  {
+    ClockedObject::unserialize(is);
+    if (is.get<int32_t>() != active_banks_ || is.get<int32_t>() != buffer_depth_)
+      throw std::runtime_error(name() + ": checkpoint bank/buffer configuration mismatch");
+    for (int bank = 0; bank < active_banks_; ++bank)
+    {
+      cmd_queues_[bank].resize(is.get<uint64_t>());
+      for (DmaCommand &cmd : cmd_queues_[bank])
+        getCommand(is, cmd);
+      getCommand(is, current_cmds_[bank]);
+
+      BankController &ctrl = bank_controllers_[bank];
+      for (BankBuffer &buf : ctrl.buffers)
+      {
+        buf.reset(burst_num_);
+        is.get(buf.dma_pkt);
+        buf.read_pos = static_cast<size_t>(is.get<uint64_t>());
+        is.get(buf.pkt_num);
+        is.get(buf.state);
+        is.get(buf.words_written);
+      }
+      is.get(ctrl.ranges);
+      is.get(ctrl.current_write_idx);
+      is.get(ctrl.stalled);
+
+      BufferOccupancy &occ = occupancy_[bank];
+      is.get(occ.used_ticks);
+      is.get(occ.full_area);
+      is.get(occ.full);
+      is.get(occ.max_full);
+      is.get(occ.last);
+    }
+    is.get(inst_cnts_);
+    is.get(trans_states_);
+    is.get(lines_fetched_for_cmds_);
+    is.get(cmd_segments_);
+    is.get(cmd_lines_);
+    is.get(seg_idx_);
+    is.get(seg_left_);
+    is.get(bank_rd_addr_);
+    is.get(bank_transfer_active_);
+    is.get(current_buf_idx_);
+    is.get(buf_cmd_id_);
+    is.get(streams_);
+    is.get(issue_stats_);
+    is.get(req_fifos_);
+    is.get(req_pkt_);
+    is.get(response_retryReq);
+    is.get(response_retryResp);
+    is.get(recv_req_send_resp);
+    is.get(request_retryReq);
+    is.get(request_retryResp);
+    is.get(next_read_idx_);
+  }
+
   void DmaBuffer::maybe_notify_compute_full(int bank_id)
   {
     // 如果该bank之前有请求被拒，或当前存在FULL缓冲，尝试唤醒计算侧
@@ -1,22 +1,26 @@
 /*
- * 基于命令队列的、自动控制双缓冲的 DMA 上游模块。
+ * 基于命令队列的、自动控制多缓冲（环形，深度可配）的 DMA 上游模块。
  * 作为一个忠实的指令执行引擎，处理来自主控的DMA命令。
  */
 
  #ifndef GNN_DMABUFFER_H_
  #define GNN_DMABUFFER_H_
  
+#include "common/clocked.h"
 #include "common/object.h"
 #include "common/packet.h"
 #include "common/port.h"
 #include "event/eventq.h"
 #include "common/define.h"
 #include "common/file_read.h"
+#include <algorithm>
 #include <deque>
+#include <ostream>
 #include <string>
 #include <vector>
 #include <cassert>
 #include <functional> // 用于 std::function
+#include <memory>
  
  namespace GNN
  {
@@ -25,16 +29,79 @@
    enum class BufferState { FILLING, FULL };
    struct BankBuffer {
      std::vector<PacketPtr> dma_pkt;
-     uint32_t pkt_num;
+     size_t read_pos = 0; // 消费游标：[0, read_pos) 已交给下游，不再从头部擦除
+     uint32_t pkt_num = 0; // 当前命令应写入的包数，写满即 FULL
      BufferState state = BufferState::FILLING;
      int words_written = 0;
+
+     bool drained() const { return read_pos >= dma_pkt.size(); }
+     size_t pending() const { return dma_pkt.size() - read_pos; }
+     PacketPtr front() const { return dma_pkt[read_pos]; }
+     // 清空缓冲：尚未交给下游的包归还对象池
+     void reset(size_t reserve)
+     {
+       for (size_t i = read_pos; i < dma_pkt.size(); ++i)
+         PacketManager::free_packet(dma_pkt[i]);
+       dma_pkt.clear();
+       dma_pkt.reserve(reserve);
+       read_pos = 0;
+     }
    };
+   // 缓冲中一段连续槽位对应的 bank 内地址区间：[first, last] 按 bank 行步长递增
+   struct BufferRange {
+     addr_t first;
+     addr_t last;
+     int slot;
+   };
+   // 每个 bank 的缓冲环：按序写入、按序读出，深度由 DmaBuffer::setBufferDepth 决定
    struct BankController {
-     BankBuffer buffers[2]; // 0=Ping, 1=Pong
-     addr_t dram_base_addr[2];
-     addr_t dram_final_addr[2];
+     std::vector<BankBuffer> buffers;
+     std::vector<std::vector<BufferRange>> ranges; // [buf] 响应按地址落到对应槽位
      int current_write_idx = 0;
-     bool stalled[2] = {false, false};
+     std::vector<bool> stalled;
+   };
+   // 每个 bank 的缓冲占用统计（按时间加权）
+   struct BufferOccupancy {
+     std::vector<Tick> used_ticks; // [n] 有 n 个缓冲被命令占用的累计时长
+     Tick full_area = 0;           // FULL 缓冲数对时间的积分
+     int full = 0;
+     int max_full = 0;
+     Tick last = 0;
+   };
+   // 每个 bank 的请求发出统计，周期数只计有请求待发或正在搬运的周期
+   struct IssueStats {
+     uint64_t issued = 0;
+     uint64_t active = 0;  // 端口未反压的活跃周期
+     uint64_t full = 0;    // 其中发满发射宽度的周期
+     uint64_t starved = 0; // 其中待发请求不足发射宽度的周期
+     Tick blocked = 0;     // 端口拒绝后等待重试的周期
+     Tick blocked_since = 0;
+   };
+   // 每个 bank 的命令流检测：相邻线性命令基址之差连续相同、行数不变即认定为顺序流
+   struct StreamDetector {
+     static constexpr int kConfirm = 2; // 连续命中该次数后认定
+     addr_t last_base = 0;
+     int64_t stride = 0;
+     int lines = 0; // 最近一条命令的行数，非线性命令为 0，不认定
+     int confidence = 0;
+     bool valid = false;
+     uint64_t chained = 0; // 命令衔接时未留空拍的次数
+
+     bool confirmed() const { return confidence >= kConfirm && lines > 0; }
+     void train(addr_t base, int cmd_lines)
+     {
+       int64_t delta = static_cast<int64_t>(base) - static_cast<int64_t>(last_base);
+       if (valid && delta == stride && cmd_lines == lines)
+         confidence = std::min(confidence + 1, kConfirm);
+       else
+       {
+         stride = delta;
+         confidence = 0;
+       }
+       last_base = base;
+       lines = cmd_lines;
+       valid = true;
+     }
    };
    enum TransState {
      IDLE,
@@ -42,14 +109,25 @@
      STREAMING
    };
  
-   class DmaBuffer : public SimObject, public FileReader
+   class DmaBuffer : public ClockedObject, public FileReader
    {
    public:
-     static constexpr int num_ports = 8;
-     static constexpr uint32_t addr_stride = 64;
+     static constexpr uint32_t addr_stride = 64; // 逻辑行大小，同 AddrInterleave::kLineBytes
      
  
+     // 一段连续数据：从 base_addr 之后属于本 bank 的首行起取 lines 行
+     struct DmaSegment
+     {
+      addr_t base_addr;
+      int lines;
+     };
+
      // --- 命令结构体定义 ---
+     // 一条命令填满一个缓冲，数据可来自多段：
+     //   线性：base_addr 起 total_lines 行；
+     //   2D 跨步：rows 行，第 r 行从 base_addr + r * row_stride 起取 total_lines 行；
+     //   分散/聚集：segments 非空时按列表依次取，忽略上面三项；
+     //   链接：next 的数据接在本命令之后写入同一缓冲，整条链只回调一次
      struct DmaCommand
      {
       int bank_id; // 新增，指令专属bank
@@ -58,14 +136,29 @@
       uint64_t cmd_id; // 用于跟踪命令的唯一ID
       // 命令完成回调：当DMA完成数据 *获取* 后调用
       std::function<void(uint64_t cmd_id)> completion_callback;
+      int rows = 1;
+      addr_t row_stride = 0;
+      std::vector<DmaSegment> segments;
+      std::shared_ptr<const DmaCommand> next;
+
+      // 展开整条链为段列表，返回总行数
+      int flatten(std::vector<DmaSegment> &out) const;
+      // 单段线性命令，流检测只学习这一种
+      bool linear() const { return rows == 1 && segments.empty() && !next; }
      };
  
      DmaBuffer(const std::string &name, addr_t base_addr, int burst_num,
-               int active_banks = num_ports, uint32_t total_slice_num_cfg = 1, uint32_t total_inst_num_cfg = 1, const std::string& data_file_base_path = "./data/", const std::string& data_file_suffix = ".txt");
+               int active_banks = CHANNEL_NUM, uint32_t total_slice_num_cfg = 1, uint32_t total_inst_num_cfg = 1, const std::string& data_file_base_path = "./data/", const std::string& data_file_suffix = ".txt");
  /**
 burst_num_ 是多少个Burst
  */
      void init() override;
+     void memoryModeChanged() override;
+     // 归还缓冲中未交给下游的数据、待发的读请求和尚未应答的下游请求
+     void releasePackets() override;
+     // 检查点：命令队列、缓冲环、待发请求与统计；命令完成回调无法保存，须为空
+     void serialize(SectionOut &os) const override;
+     void unserialize(SectionIn &is) override;
  
      // --- 端口 API ---
      bool recvTimingResp(PacketPtr pkt, int port_id);
@@ -81,6 +174,18 @@ burst_num_ 是多少个Burst
  
      // API: 查询数据
      int getReadableBufferIndex(int bank_id) const;
+
+     // 每个 bank 的缓冲个数（默认 2 即乒乓），须在 init 之前设置
+     void setBufferDepth(int depth);
+     int bufferDepth() const { return buffer_depth_; }
+     // 流检测：学习子类命令的基址跨步，认定为顺序流的 bank 发完一条命令的同一周期
+     // 接着配置已排队的下一条并发出首行，命令衔接处不留空拍。只衔接子类已下发的命令，
+     // 不按预测地址提前取数
+     void setStreamDetect(bool on) { stream_detect_ = on; }
+     // 每 bank 每周期最多生成并发出的读请求数（默认 1），端口拒绝时当周期停止发送
+     void setIssueWidth(int width);
+     // 各 bank 缓冲占用：平均占用/FULL 个数、最大 FULL 个数、占满时间比例
+     void printStats(std::ostream &os) const;
  
    
 
@@ -97,6 +202,10 @@ burst_num_ 是多少个Burst
      std::vector<int> inst_cnts_; // 每个bank的活跃指令计数
      std::vector<TransState> trans_states_; // 每个bank的状态机状态
      std::vector<int> lines_fetched_for_cmds_; // 每个bank搬运进度
+     std::vector<std::vector<DmaSegment>> cmd_segments_; // 每个bank当前命令展开后的段
+     std::vector<int> cmd_lines_;                        // 当前命令总行数
+     std::vector<size_t> seg_idx_;                       // 正在发出的段
+     std::vector<int> seg_left_;                         // 该段剩余行数
      std::vector<BankController> bank_controllers_;
      // 移除原有全局唯一命令队列/状态/计数等（已在上方替代）
      // std::deque<DmaCommand> cmd_queue_;
@@ -106,22 +215,29 @@ burst_num_ 是多少个Burst
      // int lines_fetched_for_cmd_ = 0;
      const int burst_num_;
      const int active_banks_;
-     addr_t bank_rd_addr_[num_ports]{};
-     bool bank_transfer_active_[num_ports]{};
-     uint32_t addr_stride_;
+     // 以下每bank状态均按 active_banks_ 动态分配
+     std::vector<addr_t> bank_rd_addr_;
+     std::vector<bool> bank_transfer_active_;
+     uint32_t addr_stride_;  // 所有通道各一行的地址跨度（active_banks_ * addr_stride）
     
-     // 当前命令使用的buf索引 (0 或 1)
-     bool current_buf_idx_[num_ports] ;
+     int buffer_depth_ = 2;
+     // 当前命令使用的buf索引，[0, buffer_depth_) 内轮转
+     std::vector<int> current_buf_idx_;
      // 每个buf对应的命令ID，用于正确识别数据来源
-     uint64_t buf_cmd_id_[num_ports][2] = {{0, 0},{0, 0},{0, 0},{0, 0},{0, 0},{0, 0},{0, 0},{0, 0}};
+     std::vector<std::vector<uint64_t>> buf_cmd_id_;
      // 每个buf对应的命令回调函数
-     std::function<void(uint64_t)> buf_cmd_callback_[num_ports][2] = {{nullptr, nullptr},{nullptr, nullptr},{nullptr, nullptr},{nullptr, nullptr},{nullptr, nullptr},{nullptr, nullptr},{nullptr, nullptr},{nullptr, nullptr}};
+     std::vector<std::vector<std::function<void(uint64_t)>>> buf_cmd_callback_;
+     std::vector<BufferOccupancy> occupancy_;
+     bool stream_detect_ = false;
+     std::vector<StreamDetector> streams_;
+     int issue_width_ = 1;
+     std::vector<IssueStats> issue_stats_;
  
      // --- 内部资源 ---
   
    
      std::vector<std::deque<PacketPtr>> req_fifos_;
-     PacketPtr req_pkt_[num_ports];
+     std::vector<PacketPtr> req_pkt_;
      class DmaRequestPort : public RequestPort
      {
        DmaBuffer &owner;
@@ -132,9 +248,9 @@ burst_num_ 是多少个Burst
        bool recvTimingResp(PacketPtr pkt) override;
        
        void recvReqRetry() override;
+       void recvCredit() override;
      };
      std::vector<DmaRequestPort> requestPorts;
-     EventFunctionWrapper sendRespondEvent;
      // 计算侧端口（响应端），供计算模块作为请求端发起拉取
      class ComputeSidePort : public ResponsePort
      {
@@ -151,25 +267,40 @@ burst_num_ 是多少个Burst
      std::vector<std::deque<PacketPtr>> compute_resp_fifos_;
      
       
-     bool response_retryReq[num_ports];  // 记录每个bank是否等待发送请求的重试
-     bool response_retryResp[num_ports]; // 记录每个bank是否等待发送响应的重试
-     bool recv_req_send_resp[num_ports]; // 记录每个bank是否等待接收响应
+     std::vector<bool> response_retryReq;  // 记录每个bank是否等待发送请求的重试
+     std::vector<bool> response_retryResp; // 记录每个bank是否等待发送响应的重试
+     std::vector<bool> recv_req_send_resp; // 记录每个bank是否等待接收响应
 
      
     
-    bool request_retryReq[num_ports];//记录是否重新请求数据
-     bool request_retryResp[num_ports]; // 记录每个bank是否等待发送响应的重试
-     EventFunctionWrapper tickEvent;
-     // 读出轮转偏好：在两个 FULL 缓冲间轮转选择
-     bool next_read_idx_[num_ports];
+    std::vector<bool> request_retryReq;//记录是否重新请求数据
+     std::vector<bool> request_retryResp; // 记录每个bank是否等待发送响应的重试
+     // 下一个读出的buf：与写入同序轮转，保证命令按序交给下游
+     std::vector<int> next_read_idx_;
     // --- 行为 ---
     void tick();
+    // 推进单个bank的命令状态机一步
+    void advanceBank(int bank);
+    // 功能模式：即时取数，推进该bank的状态机直到有一个可读缓冲
+    void fetchFunctional(int bank);
     virtual bool recvTimingReq(PacketPtr pkt, uint32_t bank_id) ;
+    // 各 bank 自行组织应答
     virtual void sendRespond() = 0;
     void schedule_tick_if_needed();
+    // 所有bank无命令、无待发请求时视为静止
+    bool quiescent() const;
+    // 所有bank空闲且只剩等待重试的请求
+    bool waitingRetryOnly() const;
     void check_current_cmd_completion();
     void check_buf_cmd_completion(int buf_idx,int port_id);
     void maybe_notify_compute_full(int bank_id);
+    // 按 buffer_depth_ 重建各 bank 的缓冲环
+    void allocBuffers();
+    // 占用变化前调用，把上次变化以来的时长计入统计
+    void noteOccupancy(int bank);
+
+     MemberEventWrapper<&DmaBuffer::sendRespond> sendRespondEvent;
+     MemberEventWrapper<&DmaBuffer::tick> tickEvent;
    };
  
  } // namespace GNN
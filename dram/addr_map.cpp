@@ -0,0 +1,252 @@
+#include "dram/addr_map.h"
+#include <cassert>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+namespace GNN {
+
+static int logBase2(int v) {
+  int n = 0;
+  while (v > 1) {
+    v >>= 1;
+    ++n;
+  }
+  return n;
+}
+
+static std::string trim(const std::string &s) {
+  size_t b = s.find_first_not_of(" \t\r");
+  if (b == std::string::npos)
+    return "";
+  size_t e = s.find_last_not_of(" \t\r");
+  return s.substr(b, e - b + 1);
+}
+
+DramAddrMap::DramAddrMap(const std::string &config_file) {
+  std::ifstream in(config_file);
+  if (!in)
+    throw std::runtime_error("cannot read DRAM config: " + config_file);
+  // 只取地址映射需要的键，键名在各 section 中唯一，忽略 section
+  std::map<std::string, std::string> kv;
+  std::string line;
+  while (std::getline(in, line)) {
+    size_t c = line.find_first_of(";#");
+    if (c != std::string::npos)
+      line.resize(c);
+    size_t eq = line.find('=');
+    if (eq == std::string::npos)
+      continue;
+    kv[trim(line.substr(0, eq))] = trim(line.substr(eq + 1));
+  }
+  int found = 0;
+  // 值必须是完整的正整数；pow2 的字段按位宽解码，非 2 的幂会被悄悄截断
+  auto getInt = [&](const char *key, int &v, bool pow2) {
+    auto it = kv.find(key);
+    if (it == kv.end())
+      return;
+    size_t used = 0;
+    try {
+      v = std::stoi(it->second, &used);
+    } catch (const std::exception &) {
+      used = 0;
+    }
+    if (used == 0 || used != it->second.size() || v <= 0 ||
+        (pow2 && (v & (v - 1)) != 0))
+      throw std::runtime_error(config_file + ": invalid " + key + " = " +
+                               it->second);
+    ++found;
+  };
+  getInt("channels", channels, true);
+  getInt("bankgroups", bankgroups, true);
+  getInt("banks_per_group", banks_per_group, true);
+  getInt("rows", rows, true);
+  getInt("columns", columns, true);
+  getInt("device_width", device_width, false);
+  getInt("bus_width", bus_width, false);
+  getInt("BL", burst_length, true);
+  getInt("channel_size", channel_size, false);
+  auto it = kv.find("address_mapping");
+  if (it != kv.end()) {
+    address_mapping = it->second;
+    ++found;
+  }
+  if (found == 0)
+    throw std::runtime_error("no DRAM structure keys in " + config_file);
+
+  // rank 数由容量推出，同 DRAMsim3 Config::CalculateSize
+  int devices_per_rank = bus_width / device_width;
+  int page_size = columns * device_width / 8;
+  int megs_per_bank = page_size * (rows / 1024) / 1024;
+  int megs_per_rank = megs_per_bank * bankgroups * banks_per_group * devices_per_rank;
+  ranks = megs_per_rank > channel_size ? 1 : channel_size / megs_per_rank;
+  setMapping();
+}
+
+void DramAddrMap::setMapping() {
+  shift_bits = logBase2(bus_width / 8 * burst_length);
+  std::map<std::string, int> widths = {
+      {"ch", logBase2(channels)},
+      {"ra", logBase2(ranks)},
+      {"bg", logBase2(bankgroups)},
+      {"ba", logBase2(banks_per_group)},
+      {"ro", logBase2(rows)},
+      {"co", logBase2(columns) - logBase2(burst_length)}};
+  if (address_mapping.size() != 12)
+    throw std::runtime_error("invalid address_mapping: " + address_mapping);
+
+  // 映射串从高位到低位书写，每个字段两个字符
+  std::map<std::string, int> pos;
+  int p = 0;
+  for (int i = static_cast<int>(address_mapping.size()) - 2; i >= 0; i -= 2) {
+    std::string token = address_mapping.substr(i, 2);
+    if (!widths.count(token))
+      throw std::runtime_error("invalid address_mapping field: " + token);
+    pos[token] = p;
+    p += widths[token];
+  }
+  ch_pos = pos.at("ch");
+  channel_bits = widths["ch"];
+  ra_pos = pos.at("ra");
+  bg_pos = pos.at("bg");
+  ba_pos = pos.at("ba");
+  ro_pos = pos.at("ro");
+  co_pos = pos.at("co");
+  ch_mask = (1ULL << widths["ch"]) - 1;
+  ra_mask = (1ULL << widths["ra"]) - 1;
+  bg_mask = (1ULL << widths["bg"]) - 1;
+  ba_mask = (1ULL << widths["ba"]) - 1;
+  ro_mask = (1ULL << widths["ro"]) - 1;
+  co_mask = (1ULL << widths["co"]) - 1;
+}
+
+DramCoord DramAddrMap::decode(uint64_t addr) const {
+  addr >>= shift_bits;
+  DramCoord c;
+  c.channel = static_cast<int>((addr >> ch_pos) & ch_mask);
+  c.rank = static_cast<int>((addr >> ra_pos) & ra_mask);
+  c.bankgroup = static_cast<int>((addr >> bg_pos) & bg_mask);
+  c.bank = static_cast<int>((addr >> ba_pos) & ba_mask);
+  c.row = static_cast<int>((addr >> ro_pos) & ro_mask);
+  c.column = static_cast<int>((addr >> co_pos) & co_mask);
+  return c;
+}
+
+
+// ---------------- 地址交织 ----------------
+
+AddrInterleave::Policy AddrInterleave::parsePolicy(const std::string &name) {
+  if (name == "linear")
+    return Policy::Linear;
+  if (name == "xor")
+    return Policy::Xor;
+  if (name == "perm")
+    return Policy::Permute;
+  throw std::runtime_error("invalid address interleave: " + name +
+                           " (linear|xor|perm)");
+}
+
+AddrInterleave::AddrInterleave(const DramAddrMap &map, int channels,
+                               Policy policy, const std::vector<int> &perm)
+    : map(map), channels(channels), policy_(policy), perm(perm) {
+  if (channels <= 0)
+    throw std::runtime_error("invalid channel count for address interleave");
+  if (policy_ != Policy::Linear && channels > map.numChannels())
+    throw std::runtime_error("address interleave uses more channels than "
+                             "the DRAMsim3 config provides");
+  inv_perm.assign(perm.size(), -1);
+  for (size_t i = 0; i < perm.size(); ++i) {
+    int src = perm[i];
+    if (src < 0 || static_cast<size_t>(src) >= perm.size() || inv_perm[src] >= 0)
+      throw std::runtime_error("address interleave perm is not a permutation");
+    inv_perm[src] = static_cast<int>(i);
+  }
+  uint64_t ch_mask = map.channelMask();
+  for (int b = 0; b < 64; ++b)
+    if (!((ch_mask >> b) & 1))
+      free_bits.push_back(b);
+}
+
+const char *AddrInterleave::name() const {
+  switch (policy_) {
+  case Policy::Xor:
+    return "xor";
+  case Policy::Permute:
+    return "perm";
+  default:
+    return "linear";
+  }
+}
+
+// dst 的第 i 位取自 v 的第 src[i] 位，超出 src 长度的高位不动
+static uint64_t permuteBits(uint64_t v, const std::vector<int> &src) {
+  if (src.empty())
+    return v;
+  uint64_t low = src.size() >= 64 ? ~0ULL : (1ULL << src.size()) - 1;
+  uint64_t out = v & ~low;
+  for (size_t i = 0; i < src.size(); ++i)
+    out |= ((v >> src[i]) & 1) << i;
+  return out;
+}
+
+uint64_t AddrInterleave::bankHash(uint64_t phys) const {
+  // 行号按 bank 位宽分段折叠异或，行号不变，因而变换是自逆的
+  DramCoord c = map.decode(phys);
+  uint64_t nb = static_cast<uint64_t>(map.numBankgroups()) * map.banksPerGroup();
+  uint64_t h = 0;
+  for (uint64_t r = static_cast<uint64_t>(c.row); r != 0; r /= nb)
+    h ^= r % nb;
+  return map.bankBits(static_cast<int>(h / map.banksPerGroup()),
+                      static_cast<int>(h % map.banksPerGroup()));
+}
+
+uint64_t AddrInterleave::toPhys(uint64_t addr) const {
+  if (policy_ == Policy::Linear)
+    return addr;
+  uint64_t line = addr / kLineBytes;
+  int ch = static_cast<int>(line % channels);
+  uint64_t w = line / channels;
+  if (policy_ == Policy::Permute)
+    w = permuteBits(w, perm);
+  // 通道内字节偏移依次填入非通道位
+  uint64_t v = w * kLineBytes + addr % kLineBytes;
+  uint64_t phys = map.channelBits(ch);
+  for (size_t i = 0; i < free_bits.size() && v != 0; ++i, v >>= 1)
+    phys |= (v & 1) << free_bits[i];
+  if (policy_ == Policy::Xor)
+    phys ^= bankHash(phys);
+  return phys;
+}
+
+uint64_t AddrInterleave::toLogical(uint64_t phys) const {
+  if (policy_ == Policy::Linear)
+    return phys;
+  if (policy_ == Policy::Xor)
+    phys ^= bankHash(phys);
+  int ch = map.decode(phys).channel;
+  uint64_t v = 0;
+  for (size_t i = 0; i < free_bits.size(); ++i)
+    v |= ((phys >> free_bits[i]) & 1) << i;
+  uint64_t w = v / kLineBytes;
+  if (policy_ == Policy::Permute)
+    w = permuteBits(w, inv_perm);
+  return (w * channels + ch) * kLineBytes + v % kLineBytes;
+}
+
+int AddrInterleave::verify(const std::function<int(uint64_t)> &dram_channel,
+                           int lines) const {
+  int mismatches = 0;
+  for (int ch = 0; ch < channels; ++ch) {
+    for (int k = 0; k < lines; ++k) {
+      uint64_t addr = (static_cast<uint64_t>(k) * channels + ch) * kLineBytes;
+      uint64_t phys = toPhys(addr);
+      assert(toLogical(phys) == addr);
+      if (dram_channel(phys) != ch)
+        ++mismatches;
+    }
+  }
+  return mismatches;
+}
+
+} // namespace GNN
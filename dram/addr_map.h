@@ -0,0 +1,137 @@
+#ifndef GNN_DRAM_ADDR_MAP_H_
+#define GNN_DRAM_ADDR_MAP_H_
+
+#include "common/common.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace GNN {
+
+// 按 DRAMsim3 的地址映射规则把物理地址拆成 channel/rank/bankgroup/bank/row/col。
+// 字段宽度与位置的推导与 DRAMsim3 Config::SetAddressMapping 一致，
+// 参数取自同一份 .ini 配置，保证与 DRAMsim3 内部的解码结果相同
+struct DramCoord {
+  int channel;
+  int rank;
+  int bankgroup;
+  int bank;
+  int row;
+  int column;
+};
+
+class DramAddrMap {
+public:
+  // 配置文件无法读取、值不是合法正整数或不含任何地址映射键时抛出 std::runtime_error；
+  // 单个缺省的键取 HBM2_4Gb_x128 的值
+  explicit DramAddrMap(const std::string &config_file);
+
+  DramCoord decode(uint64_t addr) const;
+  // channel 内唯一的 bank 编号（rank, bankgroup, bank 展平）
+  int flatBank(const DramCoord &c) const {
+    return (c.rank * bankgroups + c.bankgroup) * banks_per_group + c.bank;
+  }
+  int banksPerChannel() const { return ranks * bankgroups * banks_per_group; }
+  int numChannels() const { return channels; }
+  int numBankgroups() const { return bankgroups; }
+  int banksPerGroup() const { return banks_per_group; }
+
+  // 各字段在字节地址中的位置，供地址交织直接改写对应的位
+  uint64_t channelMask() const { return ch_mask << (ch_pos + shift_bits); }
+  uint64_t channelBits(int ch) const {
+    return static_cast<uint64_t>(ch) << (ch_pos + shift_bits);
+  }
+  // 去掉/补回通道字段：单通道配置的 DRAMsim3 实例按去掉通道位后的地址解码
+  uint64_t removeChannel(uint64_t addr) const {
+    int pos = ch_pos + shift_bits;
+    uint64_t low = addr & ((1ULL << pos) - 1);
+    return ((addr >> pos >> channel_bits) << pos) | low;
+  }
+  uint64_t insertChannel(uint64_t addr, int ch) const {
+    int pos = ch_pos + shift_bits;
+    uint64_t low = addr & ((1ULL << pos) - 1);
+    return ((addr >> pos) << pos << channel_bits) | channelBits(ch) | low;
+  }
+  uint64_t bankBits(int bankgroup, int bank) const {
+    return ((static_cast<uint64_t>(bankgroup) << bg_pos) |
+            (static_cast<uint64_t>(bank) << ba_pos))
+           << shift_bits;
+  }
+
+private:
+  void setMapping();
+
+  int channels = 8;
+  int ranks = 1;
+  int bankgroups = 4;
+  int banks_per_group = 4;
+  int rows = 16384;
+  int columns = 64;
+  int device_width = 128;
+  int bus_width = 128;
+  int burst_length = 4;
+  int channel_size = 512; // MB
+  std::string address_mapping = "rorabgbachco";
+
+  int shift_bits = 0;
+  int channel_bits = 0;
+  int ch_pos = 0, ra_pos = 0, bg_pos = 0, ba_pos = 0, ro_pos = 0, co_pos = 0;
+  uint64_t ch_mask = 0, ra_mask = 0, bg_mask = 0, ba_mask = 0, ro_mask = 0,
+           co_mask = 0;
+};
+
+// 逻辑地址（DMA 地址生成器与 SimDramStorage 使用）按 64B 行在通道间线性交织，
+// 第 k 行属于通道 k % N，每个 DMA bank 固定走同编号的 DramArb/DRAM 通道。
+// AddrInterleave 在 DramArb 入口把逻辑地址换成送往 DRAM 的物理地址，响应回上游前换回：
+//   linear：物理地址即逻辑地址，要求 DRAMsim3 配置把通道放在 64B 行对应的地址位上；
+//   xor：通道内偏移按 DRAMsim3 配置的字段顺序填入非通道位，再把行号折叠异或到
+//        bankgroup/bank 上，使相距整行倍数的区域（bitmap/weight/feature）落到不同 bank；
+//   perm：通道内偏移的行号位按 perm 重排后同样填入非通道位，perm[i] 为第 i 位的来源位，
+//        未列出的高位不动；perm 为空即按 DRAMsim3 原生字段顺序排布。
+// 通道由 DMA bank 决定，各策略都只重排通道内的位；xor/perm 的通道字段按同一份
+// DRAMsim3 配置编码，DRAMsim3 解出的通道必与 DMA bank 一致
+class AddrInterleave {
+public:
+  enum class Policy { Linear, Xor, Permute };
+  static constexpr uint64_t kLineBytes = 64;
+
+  // 名称不合法时抛出 std::runtime_error
+  static Policy parsePolicy(const std::string &name);
+  // perm 不是 0..n-1 的排列、或通道数超出 DRAMsim3 配置时抛出 std::runtime_error
+  AddrInterleave(const DramAddrMap &map, int channels,
+                 Policy policy = Policy::Linear,
+                 const std::vector<int> &perm = {});
+
+  // 逻辑布局：地址所在的通道，以及 base 之后第一个属于 channel 的行
+  static int lineChannel(uint64_t addr, int channels) {
+    return static_cast<int>((addr / kLineBytes) % channels);
+  }
+  static uint64_t firstLine(uint64_t base, int channel, int channels) {
+    int ori = lineChannel(base, channels);
+    return base + static_cast<uint64_t>((channel - ori + channels) % channels) *
+                      kLineBytes;
+  }
+
+  uint64_t toPhys(uint64_t addr) const;
+  uint64_t toLogical(uint64_t addr) const;
+  Policy policy() const { return policy_; }
+  const char *name() const;
+  // 用 DRAM 后端的通道函数抽查每个通道的前 lines 行，返回通道不一致的行数
+  int verify(const std::function<int(uint64_t)> &dram_channel,
+             int lines = 256) const;
+
+private:
+  uint64_t bankHash(uint64_t phys) const;
+
+  DramAddrMap map;
+  int channels;
+  Policy policy_;
+  std::vector<int> perm;
+  std::vector<int> inv_perm;
+  std::vector<int> free_bits; // 物理地址中非通道字段的位，从低到高
+};
+
+} // namespace GNN
+
+#endif // GNN_DRAM_ADDR_MAP_H_
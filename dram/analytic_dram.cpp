@@ -0,0 +1,358 @@
+#include "dram/analytic_dram.h"
+#include "common/debug.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace GNN {
+
+// ---------------- 参数文件 ----------------
+
+static std::vector<double> parseList(const std::string &s) {
+  std::vector<double> v;
+  std::stringstream ss(s);
+  std::string item;
+  while (std::getline(ss, item, ','))
+    v.push_back(std::stod(item));
+  return v;
+}
+
+DramModelParams DramModelParams::load(const std::string &path) {
+  std::ifstream in(path);
+  if (!in)
+    throw std::runtime_error("cannot open dram model: " + path);
+  std::map<std::string, std::string> kv;
+  std::string line;
+  while (std::getline(in, line)) {
+    size_t eq = line.find('=');
+    if (line.empty() || line[0] == '#' || eq == std::string::npos)
+      continue;
+    kv[line.substr(0, eq)] = line.substr(eq + 1);
+  }
+  DramModelParams p;
+  try {
+    p.service_interval = parseList(kv.at("service_interval"));
+    p.hit_latency = std::stod(kv.at("hit_latency"));
+    p.miss_penalty = std::stod(kv.at("miss_penalty"));
+    // 早于写读周转项保存的参数文件没有该键，按 0 处理
+    if (kv.count("wr_to_rd"))
+      p.wr_to_rd = std::stod(kv.at("wr_to_rd"));
+    p.queue_depth = static_cast<unsigned>(std::stoul(kv.at("queue_depth")));
+    p.residual = parseList(kv.at("residual"));
+  } catch (const std::exception &) {
+    throw std::runtime_error("invalid dram model: " + path);
+  }
+  if (p.service_interval.empty() || p.queue_depth == 0 ||
+      p.residual.size() != kResidualQuantiles)
+    throw std::runtime_error("invalid dram model: " + path);
+  return p;
+}
+
+void DramModelParams::save(const std::string &path) const {
+  std::ofstream out(path);
+  if (!out)
+    throw std::runtime_error("cannot write dram model: " + path);
+  auto list = [&out](const std::vector<double> &v) {
+    for (size_t i = 0; i < v.size(); ++i)
+      out << (i ? "," : "") << v[i];
+    out << "\n";
+  };
+  out << "# fitted from a DRAMsim3 calibration run\n";
+  out << "service_interval=";
+  list(service_interval);
+  out << "hit_latency=" << hit_latency << "\n";
+  out << "miss_penalty=" << miss_penalty << "\n";
+  out << "wr_to_rd=" << wr_to_rd << "\n";
+  out << "queue_depth=" << queue_depth << "\n";
+  out << "residual=";
+  list(residual);
+}
+
+// ---------------- 排队模型 ----------------
+
+DramQueueModel::DramQueueModel(const DramModelParams &params,
+                               const DramAddrMap &map, int channel,
+                               bool use_residual)
+    : params(params), map(map), use_residual(use_residual),
+      bank_free(map.banksPerChannel(), 0.0),
+      open_row(map.banksPerChannel(), -1) {
+  // 校准时的通道数可能少于当前运行，取最后一个通道的参数
+  assert(!params.service_interval.empty());
+  interval = params.service_interval[std::min<size_t>(
+      channel, params.service_interval.size() - 1)];
+  rng += static_cast<uint64_t>(channel);
+}
+
+Tick DramQueueModel::access(uint64_t addr, bool is_write, Tick now,
+                            double *start_out) {
+  DramCoord c = map.decode(addr);
+  int bank = map.flatBank(c);
+  bool miss = open_row[bank] >= 0 && open_row[bank] != c.row;
+  open_row[bank] = c.row;
+
+  // 通道按带宽串行发出，行冲突时还要等该 bank 完成上一次换行
+  double start = std::max<double>(now, next_free);
+  start = std::max(start, bank_free[bank]);
+  next_free = start + interval;
+  // 紧跟写的读要等总线周转，写已让出通道足够久时不再有影响
+  double turnaround = 0;
+  if (!is_write && last_write)
+    turnaround = std::max(0.0, write_free + params.wr_to_rd - start);
+  if (is_write)
+    write_free = next_free;
+  last_write = is_write;
+  if (miss)
+    bank_free[bank] = start + params.miss_penalty;
+
+  double latency =
+      params.hit_latency + (miss ? params.miss_penalty : 0.0) + turnaround;
+  if (use_residual && !params.residual.empty()) {
+    rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+    latency += params.residual[(rng >> 33) % params.residual.size()];
+  }
+  if (start_out)
+    *start_out = start;
+  double done = start + std::max(latency, 1.0);
+  return static_cast<Tick>(std::ceil(done));
+}
+
+// ---------------- 校准 ----------------
+
+DramCalibration::DramCalibration(const DramAddrMap &map, int channels,
+                                 size_t max_records)
+    : map(map), max_records(max_records), records(channels),
+      pending(channels) {}
+
+void DramCalibration::accept(int channel, PacketPtr pkt, Tick now) {
+  // 只取运行开头的一段作为校准样本
+  if (num_records >= max_records)
+    return;
+  ++num_records;
+  pending[channel][pkt] = records[channel].size();
+  records[channel].push_back({pkt->getAddr(), pkt->isWrite(), now, 0});
+}
+
+void DramCalibration::complete(int channel, PacketPtr pkt, Tick now) {
+  auto it = pending[channel].find(pkt);
+  if (it == pending[channel].end())
+    return;
+  records[channel][it->second].complete = now;
+  pending[channel].erase(it);
+}
+
+// v 须已排序
+static double percentile(const std::vector<double> &v, double q) {
+  if (v.empty())
+    return 0.0;
+  return v[static_cast<size_t>(q * (v.size() - 1))];
+}
+
+DramModelParams DramCalibration::fit() const {
+  DramModelParams p;
+  unsigned max_depth = 1;
+
+  for (const auto &recs : records) {
+    // 事务区间按时刻排序扫描，得到在途深度与积压期间的完成间隔
+    std::vector<std::pair<Tick, int>> edges;
+    for (const Record &r : recs) {
+      if (r.complete == 0)
+        continue;
+      edges.push_back({r.accept, 1});
+      edges.push_back({r.complete, -1});
+    }
+    std::sort(edges.begin(), edges.end(),
+              [](const std::pair<Tick, int> &a, const std::pair<Tick, int> &b) {
+                return a.first != b.first ? a.first < b.first
+                                          : a.second < b.second;
+              });
+    int depth = 0;
+    std::vector<double> gaps;
+    Tick last_complete = 0;
+    bool have_last = false;
+    for (const auto &e : edges) {
+      if (e.second < 0) {
+        // 完成前仍有其他事务在途，说明通道处于积压状态，间隔反映持续带宽；
+        // 取中位数，排除积压但队首尚未就绪造成的长间隔
+        if (have_last && depth >= 2)
+          gaps.push_back(double(e.first - last_complete));
+        last_complete = e.first;
+        have_last = true;
+      }
+      depth += e.second;
+      max_depth = std::max<unsigned>(max_depth, depth);
+    }
+    std::sort(gaps.begin(), gaps.end());
+    p.service_interval.push_back(gaps.empty() ? 1.0
+                                              : std::max(percentile(gaps, 0.5), 0.01));
+  }
+  p.queue_depth = max_depth;
+
+  // 按拟合的带宽回放得到每个事务在通道上的发出时刻，完成时刻减去发出时刻即
+  // 扣除排队后的访问延迟；低分位数近似无负载延迟
+  // 排队中紧跟写发出的读（发出时刻即写让出通道的时刻）单独收集，其延迟多出的部分即写读周转
+  std::vector<double> hit_lat, miss_lat;
+  std::vector<std::pair<double, bool>> turn_lat; // (访问延迟, 是否行冲突)
+  for (size_t ch = 0; ch < records.size(); ++ch) {
+    DramQueueModel model(p, map, static_cast<int>(ch), false);
+    std::vector<int> open_row(map.banksPerChannel(), -1);
+    bool last_write = false;
+    for (const Record &r : records[ch]) {
+      if (r.complete == 0)
+        continue;
+      double start = 0;
+      model.access(r.addr, r.is_write, r.accept, &start);
+      DramCoord c = map.decode(r.addr);
+      int &row = open_row[map.flatBank(c)];
+      bool miss = row >= 0 && row != c.row;
+      row = c.row;
+      if (!r.is_write) {
+        double lat = double(r.complete) - start;
+        if (last_write && start > double(r.accept))
+          turn_lat.push_back({lat, miss});
+        else
+          (miss ? miss_lat : hit_lat).push_back(lat);
+      }
+      last_write = r.is_write;
+    }
+  }
+  std::sort(hit_lat.begin(), hit_lat.end());
+  std::sort(miss_lat.begin(), miss_lat.end());
+  p.hit_latency = std::max(percentile(hit_lat, 0.05), 1.0);
+  p.miss_penalty =
+      miss_lat.empty() ? 0.0
+                       : std::max(0.0, percentile(miss_lat, 0.05) - p.hit_latency);
+  std::vector<double> turn;
+  for (const auto &t : turn_lat)
+    turn.push_back(t.first - p.hit_latency - (t.second ? p.miss_penalty : 0.0));
+  std::sort(turn.begin(), turn.end());
+  p.wr_to_rd = std::max(0.0, percentile(turn, 0.05));
+
+  // 在同一轨迹上回放不带残差的模型，残差分布补偿刷新、调度等未建模效应
+  std::vector<double> residual;
+  for (size_t ch = 0; ch < records.size(); ++ch) {
+    DramQueueModel model(p, map, static_cast<int>(ch), false);
+    for (const Record &r : records[ch]) {
+      if (r.complete == 0)
+        continue;
+      Tick modeled = model.access(r.addr, r.is_write, r.accept);
+      residual.push_back(double(r.complete) - double(modeled));
+    }
+  }
+  std::sort(residual.begin(), residual.end());
+  p.residual.resize(DramModelParams::kResidualQuantiles, 0.0);
+  for (int i = 0; i < DramModelParams::kResidualQuantiles; ++i)
+    p.residual[i] = percentile(
+        residual, (i + 0.5) / DramModelParams::kResidualQuantiles);
+  return p;
+}
+
+void DramCalibration::report(const DramModelParams &params,
+                             std::ostream &os) const {
+  double lat_real = 0, lat_model = 0, abs_err = 0;
+  size_t n = 0, writes = 0;
+  Tick span_real = 0, span_model = 0;
+  for (size_t ch = 0; ch < records.size(); ++ch) {
+    DramQueueModel model(params, map, static_cast<int>(ch));
+    for (const Record &r : records[ch]) {
+      if (r.complete == 0)
+        continue;
+      Tick modeled = model.access(r.addr, r.is_write, r.accept);
+      lat_real += double(r.complete - r.accept);
+      lat_model += double(modeled - r.accept);
+      abs_err += std::fabs(double(modeled) - double(r.complete));
+      span_real = std::max(span_real, r.complete);
+      span_model = std::max(span_model, modeled);
+      writes += r.is_write;
+      ++n;
+    }
+  }
+  os << "DramModel: samples=" << n << " writes=" << writes
+     << " queue_depth=" << params.queue_depth
+     << " hit_latency=" << params.hit_latency
+     << " miss_penalty=" << params.miss_penalty
+     << " wr_to_rd=" << params.wr_to_rd << std::endl;
+  if (n == 0)
+    return;
+  double avg_interval = 0;
+  for (double v : params.service_interval)
+    avg_interval += v;
+  avg_interval /= params.service_interval.size();
+  os << "  mean_latency real=" << lat_real / n << " model=" << lat_model / n
+     << " err=" << (lat_model - lat_real) / lat_real * 100 << "%"
+     << " mean_abs_err=" << abs_err / n << std::endl;
+  os << "  last_completion real=" << span_real << " model=" << span_model
+     << " err=" << (double(span_model) - double(span_real)) / span_real * 100
+     << "%"
+     << " service_interval=" << avg_interval << std::endl;
+}
+
+// ---------------- SimObject 后端 ----------------
+
+AnalyticDram::AnalyticDram(const std::string &name_, int channel,
+                           const DramModelParams &params,
+                           const DramAddrMap &map)
+    : SimObject(name_), channel_id(channel), queue_depth(params.queue_depth),
+      model(params, map, channel), completeEvent(*this, "completeEvent"),
+      sendResponseEvent(*this, "sendResponseEvent"),
+      port(name() + ".port", *this) {}
+
+void AnalyticDram::init() {
+  if (!port.isConnected()) {
+    D_ERROR("DRAM", "AnalyticDram %s is unconnected!\n", name().c_str());
+  }
+}
+
+bool AnalyticDram::recvTimingReq(PacketPtr pkt) {
+  if (inflight.size() >= queue_depth) {
+    retryReq = true;
+    return false;
+  }
+  Tick when = model.access(pkt->getAddr(), pkt->isWrite(), curTick());
+  inflight.push({when, seq++, pkt});
+  if (!completeEvent.scheduled() || completeEvent.when() > inflight.top().when)
+    reschedule(completeEvent, inflight.top().when, true);
+  return true;
+}
+
+void AnalyticDram::complete() {
+  while (!inflight.empty() && inflight.top().when <= curTick()) {
+    PacketPtr pkt = inflight.top().pkt;
+    inflight.pop();
+    if (pkt->isWrite()) {
+      // 与 DRAMsim3 后端一致，写完成不回响应
+      PacketManager::free_packet(pkt);
+    } else {
+      responseQueue.push_back(pkt);
+    }
+  }
+  if (!inflight.empty())
+    schedule(completeEvent, inflight.top().when);
+  if (!responseQueue.empty() && !retryResp && !sendResponseEvent.scheduled())
+    schedule(sendResponseEvent, curTick() + 1);
+  if (retryReq) {
+    retryReq = false;
+    port.sendRetryReq();
+  }
+}
+
+void AnalyticDram::sendResponse() {
+  while (!responseQueue.empty()) {
+    if (!port.sendTimingResp(responseQueue.front())) {
+      retryResp = true;
+      return;
+    }
+    responseQueue.pop_front();
+  }
+}
+
+void AnalyticDram::recvRespRetry() {
+  assert(retryResp);
+  retryResp = false;
+  sendResponse();
+}
+
+} // namespace GNN
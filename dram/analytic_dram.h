@@ -0,0 +1,142 @@
+#ifndef GNN_DRAM_ANALYTIC_DRAM_H_
+#define GNN_DRAM_ANALYTIC_DRAM_H_
+
+#include "common/object.h"
+#include "common/packet.h"
+#include "common/port.h"
+#include "dram/addr_map.h"
+#include "event/eventq.h"
+#include <deque>
+#include <ostream>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace GNN {
+
+// 排队 DRAM 模型参数，由 DRAMsim3 校准运行拟合，以 key=value 文本保存
+struct DramModelParams {
+  static constexpr int kResidualQuantiles = 16;
+
+  std::vector<double> service_interval; // [ch] 持续带宽：每个 burst 占用通道的周期数
+  double hit_latency = 0;               // 行命中的无负载延迟
+  double miss_penalty = 0;              // 行冲突（同 bank 不同行）额外延迟，期间该 bank 不可用
+  double wr_to_rd = 0;                  // 写后紧接读的周转（tWTR 等）：读完成时刻不早于写让出通道后这么久再加命中延迟
+  unsigned queue_depth = 32;            // 每通道可接受的在途事务数
+  std::vector<double> residual;         // 实测与模型延迟之差的分位数，采样叠加到延迟上
+
+  // 文件不存在或格式不符时抛出 std::runtime_error
+  static DramModelParams load(const std::string &path);
+  void save(const std::string &path) const;
+};
+
+// 单通道排队模型：通道按 service_interval 串行发出 burst，bank 遇行冲突时额外占用
+// miss_penalty，完成时刻 = 发出时刻 + 命中延迟 (+冲突惩罚) (+写读周转) + 残差采样。
+// 周转只加在写之后紧接着发出的读的延迟上，不推迟通道上后续的 burst
+class DramQueueModel {
+public:
+  DramQueueModel(const DramModelParams &params, const DramAddrMap &map,
+                 int channel, bool use_residual = true);
+  // 返回 now 到达的请求的完成时刻，start 可取回其在通道上的发出时刻
+  Tick access(uint64_t addr, bool is_write, Tick now, double *start = nullptr);
+
+private:
+  const DramModelParams &params;
+  const DramAddrMap &map;
+  double interval;
+  bool use_residual;
+  double next_free = 0;
+  bool last_write = false;
+  double write_free = 0; // 最近一次写让出通道的时刻
+  std::vector<double> bank_free;
+  std::vector<int> open_row;
+  uint64_t rng = 0x9e3779b97f4a7c15ULL;
+};
+
+// 校准：记录 DRAMsim3 每个事务的接收与完成时刻，拟合模型参数，
+// 并在同一条轨迹上回放拟合后的模型报告误差
+class DramCalibration {
+public:
+  DramCalibration(const DramAddrMap &map, int channels,
+                  size_t max_records = 1 << 20);
+  void accept(int channel, PacketPtr pkt, Tick now);
+  void complete(int channel, PacketPtr pkt, Tick now);
+
+  DramModelParams fit() const;
+  void report(const DramModelParams &params, std::ostream &os) const;
+
+private:
+  struct Record {
+    uint64_t addr;
+    bool is_write;
+    Tick accept;
+    Tick complete;
+  };
+  const DramAddrMap &map;
+  size_t max_records;
+  size_t num_records = 0;
+  std::vector<std::vector<Record>> records; // [ch]，按接收顺序
+  std::vector<std::unordered_map<PacketPtr, size_t>> pending; // [ch]
+};
+
+// DRAMsim3 的替代后端，对外同样暴露 "mem_side" 端口。
+// 拟合与误差报告只在 DRAMsim3 的替身上跑过，精度与加速都未经真实 DRAMsim3 验证
+class AnalyticDram : public SimObject {
+public:
+  AnalyticDram(const std::string &name_, int channel,
+               const DramModelParams &params, const DramAddrMap &map);
+  void init() override;
+  Port &getPort(const std::string &if_name, int = -1) override {
+    if (if_name == "mem_side")
+      return port;
+    throw std::runtime_error("No such port");
+  }
+
+private:
+  class MemoryPort : public ResponsePort {
+    AnalyticDram &mem;
+
+  public:
+    MemoryPort(const std::string &_name, AnalyticDram &_mem)
+        : ResponsePort(_name), mem(_mem) {}
+
+  protected:
+    bool recvTimingReq(PacketPtr pkt) override { return mem.recvTimingReq(pkt); }
+    void recvRespRetry() override { mem.recvRespRetry(); }
+    void recvFunctional(PacketPtr) override {}
+  };
+
+  struct Pending {
+    Tick when;
+    uint64_t seq;
+    PacketPtr pkt;
+    bool operator>(const Pending &o) const {
+      return when != o.when ? when > o.when : seq > o.seq;
+    }
+  };
+
+  bool recvTimingReq(PacketPtr pkt);
+  void recvRespRetry();
+  void complete();
+  void sendResponse();
+
+  int channel_id;
+  unsigned queue_depth;
+  DramQueueModel model;
+  std::priority_queue<Pending, std::vector<Pending>, std::greater<Pending>>
+      inflight;
+  uint64_t seq = 0;
+  std::deque<PacketPtr> responseQueue;
+  bool retryReq = false;
+  bool retryResp = false;
+  MemberEventWrapper<&AnalyticDram::complete> completeEvent;
+  MemberEventWrapper<&AnalyticDram::sendResponse> sendResponseEvent;
+
+public:
+  MemoryPort port;
+};
+
+} // namespace GNN
+
+#endif // GNN_DRAM_ANALYTIC_DRAM_H_
@@ -0,0 +1,198 @@
+#include "dram/arb_policy.h"
+#include <algorithm>
+#include <cassert>
+
+namespace GNN {
+
+FrFcfsPolicy::FrFcfsPolicy(const DramAddrMap &map, int num_banks,
+                           int num_upstreams, unsigned age_cap)
+    : map(map), age_cap(age_cap) {
+  assert(age_cap > 0);
+  DramCoord max_ch = map.decode(~0ULL);
+  last_row.assign(max_ch.channel + 1,
+                  std::vector<int>(map.banksPerChannel(), -1));
+  for (auto &b : bypass)
+    b.assign(num_banks, std::vector<unsigned>(num_upstreams, 0));
+}
+
+bool FrFcfsPolicy::isLastRowHit(PacketPtr pkt) const {
+  DramCoord c = map.decode(pkt->getAddr());
+  return last_row[c.channel][map.flatBank(c)] == c.row;
+}
+
+int FrFcfsPolicy::pick(int bank, bool is_write,
+                       const std::vector<std::deque<PacketPtr>> &fifos) {
+  const std::vector<unsigned> &age = bypass[is_write][bank];
+  int oldest = -1;
+  int oldest_hit = -1;
+  for (int up = 0; up < static_cast<int>(fifos.size()); up++) {
+    if (fifos[up].empty())
+      continue;
+    if (oldest < 0 || age[up] > age[oldest])
+      oldest = up;
+    if (isLastRowHit(fifos[up].front()) &&
+        (oldest_hit < 0 || age[up] > age[oldest_hit]))
+      oldest_hit = up;
+  }
+  // 有队首到达年龄上限时不再追求同行
+  if (oldest >= 0 && age[oldest] >= age_cap)
+    return oldest;
+  return oldest_hit >= 0 ? oldest_hit : oldest;
+}
+
+void FrFcfsPolicy::issued(int bank, bool is_write, int upstream, Tick,
+                          const std::vector<std::deque<PacketPtr>> &fifos) {
+  std::vector<unsigned> &age = bypass[is_write][bank];
+  PacketPtr pkt = fifos[upstream].front();
+  DramCoord c = map.decode(pkt->getAddr());
+  int &row = last_row[c.channel][map.flatBank(c)];
+
+  ++issued_num;
+  if (row == c.row)
+    ++last_row_hits;
+  if (age[upstream] >= age_cap)
+    ++forced_num;
+  row = c.row;
+
+  for (int up = 0; up < static_cast<int>(fifos.size()); up++) {
+    if (up != upstream && !fifos[up].empty())
+      ++age[up];
+  }
+  age[upstream] = 0;
+}
+
+void FrFcfsPolicy::report(std::ostream &os) const {
+  os << "ArbPolicy: " << name() << " issued=" << issued_num
+     << " last_row_hits=" << last_row_hits << " forced=" << forced_num;
+  if (issued_num > 0)
+    os << " last_row_hit_rate=" << 100.0 * last_row_hits / issued_num << "%";
+  os << std::endl;
+}
+
+DrrPolicy::DrrPolicy(int num_banks, const std::vector<unsigned> &weights,
+                     const std::vector<unsigned> &caps, Tick cap_window)
+    : num_upstreams(static_cast<int>(weights.size())), weights(weights),
+      caps(caps), cap_window(cap_window) {
+  assert(num_upstreams > 0 && cap_window > 0);
+  for (unsigned w : weights)
+    assert(w > 0);
+  this->caps.resize(num_upstreams, 0);
+  for (int dir = 0; dir < 2; dir++) {
+    rr_ptr[dir].assign(num_banks, 0);
+    deficit[dir].assign(num_banks, std::vector<unsigned>(num_upstreams, 0));
+  }
+  window_start.assign(num_banks, 0);
+  window_used.assign(num_banks, std::vector<unsigned>(num_upstreams, 0));
+  age_hist.assign(num_upstreams, std::vector<uint64_t>(kAgeBuckets, 0));
+  max_age.assign(num_upstreams, 0);
+  issued_num.assign(num_upstreams, 0);
+}
+
+bool DrrPolicy::capped(int bank, int up) {
+  if (caps[up] == 0)
+    return false;
+  Tick now = curTick();
+  if (now >= window_start[bank] + cap_window) {
+    window_start[bank] = now - (now - window_start[bank]) % cap_window;
+    std::fill(window_used[bank].begin(), window_used[bank].end(), 0);
+  }
+  return window_used[bank][up] >= caps[up];
+}
+
+int DrrPolicy::pick(int bank, bool is_write,
+                    const std::vector<std::deque<PacketPtr>> &fifos) {
+  assert(static_cast<int>(fifos.size()) == num_upstreams);
+  std::vector<unsigned> &dc = deficit[is_write][bank];
+  int &ptr = rr_ptr[is_write][bank];
+  // 从轮询指针开始最多走一圈；轮到的上游额度为 0 时补充 weight 个
+  for (int i = 0; i < num_upstreams; i++) {
+    int up = ptr;
+    if (fifos[up].empty()) {
+      dc[up] = 0; // 空队列不积攒额度
+    } else if (!capped(bank, up)) {
+      if (dc[up] == 0)
+        dc[up] = weights[up];
+      return up;
+    }
+    ptr = (ptr + 1) % num_upstreams;
+  }
+  return -1;
+}
+
+void DrrPolicy::issued(int bank, bool is_write, int upstream, Tick head_wait,
+                       const std::vector<std::deque<PacketPtr>> &) {
+  std::vector<unsigned> &dc = deficit[is_write][bank];
+  assert(dc[upstream] > 0);
+  // 额度用完才让给下一个上游
+  if (--dc[upstream] == 0)
+    rr_ptr[is_write][bank] = (upstream + 1) % num_upstreams;
+  ++window_used[bank][upstream];
+  ++issued_num[upstream];
+
+  Tick age = head_wait;
+  int bucket = 0;
+  while ((Tick(1) << bucket) <= age && bucket < kAgeBuckets - 1)
+    ++bucket;
+  ++age_hist[upstream][bucket];
+  max_age[upstream] = std::max(max_age[upstream], age);
+}
+
+void FrFcfsPolicy::serialize(SectionOut &os) const {
+  os.put(last_row);
+  os.put(bypass[0]);
+  os.put(bypass[1]);
+  os.put(last_row_hits);
+  os.put(issued_num);
+  os.put(forced_num);
+}
+
+void FrFcfsPolicy::unserialize(SectionIn &is) {
+  is.get(last_row);
+  is.get(bypass[0]);
+  is.get(bypass[1]);
+  is.get(last_row_hits);
+  is.get(issued_num);
+  is.get(forced_num);
+}
+
+void DrrPolicy::report(std::ostream &os) const {
+  os << "ArbPolicy: " << name() << std::endl;
+  for (int up = 0; up < num_upstreams; up++) {
+    os << "  up" << up << ": weight=" << weights[up] << " cap=" << caps[up]
+       << "/" << cap_window << " issued=" << issued_num[up]
+       << " max_wait=" << max_age[up] << " wait_hist=";
+    // 第 b 个桶统计等待 [2^(b-1), 2^b) 个周期，桶 0 为 0 周期
+    int last = kAgeBuckets - 1;
+    while (last > 0 && age_hist[up][last] == 0)
+      --last;
+    for (int b = 0; b <= last; b++)
+      os << (b ? "," : "") << age_hist[up][b];
+    os << std::endl;
+  }
+}
+
+void DrrPolicy::serialize(SectionOut &os) const {
+  for (int w = 0; w < 2; w++) {
+    os.put(rr_ptr[w]);
+    os.put(deficit[w]);
+  }
+  os.put(window_start);
+  os.put(window_used);
+  os.put(age_hist);
+  os.put(max_age);
+  os.put(issued_num);
+}
+
+void DrrPolicy::unserialize(SectionIn &is) {
+  for (int w = 0; w < 2; w++) {
+    is.get(rr_ptr[w]);
+    is.get(deficit[w]);
+  }
+  is.get(window_start);
+  is.get(window_used);
+  is.get(age_hist);
+  is.get(max_age);
+  is.get(issued_num);
+}
+
+} // namespace GNN
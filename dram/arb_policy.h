@@ -0,0 +1,107 @@
+#ifndef GNN_DRAM_ARB_POLICY_H_
+#define GNN_DRAM_ARB_POLICY_H_
+
+#include "common/packet.h"
+#include "common/serialize.h"
+#include "dram/addr_map.h"
+#include "event/eventq.h"
+#include <deque>
+#include <ostream>
+#include <vector>
+
+namespace GNN {
+
+// DramArb 的可替换仲裁策略：在某个 bank 的各上游输入队列队首之间选出本轮发送者。
+// 只在队首之间重排，单个上游内部的请求顺序保持不变
+class ArbPolicy {
+public:
+  virtual ~ArbPolicy() = default;
+  virtual const char *name() const = 0;
+  // 返回被选中的上游编号，-1 表示没有可发送的请求
+  virtual int pick(int bank, bool is_write,
+                   const std::vector<std::deque<PacketPtr>> &fifos) = 0;
+  // 选中的队首已被下游接受（尚未出队）。参数依次为 bank、是否写、上游编号、该包从成为队首到被发送
+  // 经过的周期数（由 DramArb 在入队/出队时记录）、发送前的队列状态；默认不记录
+  virtual void issued(int, bool, int, Tick,
+                      const std::vector<std::deque<PacketPtr>> &) {}
+  virtual void report(std::ostream &) const {}
+  // 检查点：保存/恢复仲裁历史与统计，构造参数不在其中
+  virtual void serialize(SectionOut &) const {}
+  virtual void unserialize(SectionIn &) {}
+};
+
+// FR-FCFS：优先发送与本策略在同一 DRAM bank 上次发出的请求同行（last-issued-row）的队首，
+// 其次发送等待最久的队首。DramArb 看不到 DRAM 控制器的真实行缓冲状态（刷新、预充电、
+// 其他来源的访问都不可见），last-issued-row 只是本策略自身发送历史的推断。
+// 某个队首被越过 age_cap 次后强制发送，避免同行请求流长期饿死其他上游。
+// 没有到达时间戳，"等待最久"用被越过次数近似，相同时编号小的上游优先
+class FrFcfsPolicy : public ArbPolicy {
+public:
+  FrFcfsPolicy(const DramAddrMap &map, int num_banks, int num_upstreams,
+               unsigned age_cap = 16);
+  const char *name() const override { return "fr-fcfs"; }
+  int pick(int bank, bool is_write,
+           const std::vector<std::deque<PacketPtr>> &fifos) override;
+  void issued(int bank, bool is_write, int upstream, Tick head_wait,
+              const std::vector<std::deque<PacketPtr>> &fifos) override;
+  void report(std::ostream &os) const override;
+  void serialize(SectionOut &os) const override;
+  void unserialize(SectionIn &is) override;
+
+  uint64_t lastRowHits() const { return last_row_hits; }
+  uint64_t issuedCount() const { return issued_num; }
+
+private:
+  bool isLastRowHit(PacketPtr pkt) const;
+
+  DramAddrMap map;
+  unsigned age_cap;
+  // 每个 DRAM 通道每个 bank 上本策略最近发出的请求所在的行，-1 表示尚未发出
+  std::vector<std::vector<int>> last_row; // [channel][flat bank]
+  // 每个队首已被越过的次数，读写分开统计
+  std::vector<std::vector<unsigned>> bypass[2]; // [is_write][bank][up]
+  uint64_t last_row_hits = 0;
+  uint64_t issued_num = 0;
+  uint64_t forced_num = 0;
+};
+
+// 加权公平仲裁（deficit round-robin）：每个上游每轮获得 weight 个 burst 的额度，
+// 按轮询顺序消耗；权重全为 1 时退化为普通轮询，请求代价恒为 1 burst 时与 WRR 等价。
+// cap 为每个上游在 cap_window 个周期内最多发送的请求数（读写合计），0 表示不限。
+// 同时按上游统计队首等待时间（成为队首到被发送）的 log2 直方图，用于调权重
+class DrrPolicy : public ArbPolicy {
+public:
+  DrrPolicy(int num_banks, const std::vector<unsigned> &weights,
+            const std::vector<unsigned> &caps = {}, Tick cap_window = 1000);
+  const char *name() const override { return "drr"; }
+  int pick(int bank, bool is_write,
+           const std::vector<std::deque<PacketPtr>> &fifos) override;
+  void issued(int bank, bool is_write, int upstream, Tick head_wait,
+              const std::vector<std::deque<PacketPtr>> &fifos) override;
+  void report(std::ostream &os) const override;
+  void serialize(SectionOut &os) const override;
+  void unserialize(SectionIn &is) override;
+
+  static constexpr int kAgeBuckets = 16;
+
+private:
+  bool capped(int bank, int up);
+
+  int num_upstreams;
+  std::vector<unsigned> weights;
+  std::vector<unsigned> caps;
+  Tick cap_window;
+
+  std::vector<int> rr_ptr[2];                     // [is_write][bank]
+  std::vector<std::vector<unsigned>> deficit[2];  // [is_write][bank][up]
+  std::vector<Tick> window_start;                 // [bank]
+  std::vector<std::vector<unsigned>> window_used; // [bank][up]
+
+  std::vector<std::vector<uint64_t>> age_hist;    // [up][bucket]
+  std::vector<Tick> max_age;                      // [up]
+  std::vector<uint64_t> issued_num;               // [up]
+};
+
+} // namespace GNN
+
+#endif // GNN_DRAM_ARB_POLICY_H_
@@ -1,18 +1,22 @@
 #include "dram_arb.h"
+#include "dram/sim_dram_storage.h"
 #include <cassert>
 #include <iostream>
 #include <stdexcept>
 
 namespace GNN {
 
-DramArb::DramArb(const std::string &_name, int buf_size_, int num_upstreams_)
+DramArb::DramArb(const std::string &_name, int buf_size_, int num_upstreams_,
+                 int num_banks_)
     : SimObject(_name), buf_size(buf_size_), num_upstreams(num_upstreams_),
+      num_banks(num_banks_),
       // 事件：仲裁和响应发送
-      arbEvent([this] { arbitrate(); }, _name + ".arbEvent"),
-      sendResponseEvent([this] { sendResponse(); },
-                        _name + ".sendResponseEvent") {
+      sendResponseEvent(*this, "sendResponseEvent"),
+      arbEvent(*this, "arbEvent") {
 
-  D_INFO("DRAM_ARB", "DramArb构造函数: num_upstreams=%d", num_upstreams);
+  D_INFO("DRAM_ARB", "DramArb构造函数: num_banks=%d, num_upstreams=%d", num_banks,
+         num_upstreams);
+  assert(num_banks > 0);
 
   // 第一步：初始化基本状态
   initializeBasicState();
@@ -34,21 +38,20 @@ DramArb::DramArb(const std::string &_name, int buf_size_, int num_upstreams_)
 }
 
 void DramArb::initializeBasicState() {
-  // 初始化每个bank的读请求计数
-  for (int bank = 0; bank < num_banks; bank++) {
-    nbrOutstandingReads[bank] = 0;
-    nbrOutstandingWrites[bank] = 0;
-  }
+  // 初始化每个bank的读写请求表与计数
+  // 表项从发往 DRAM 到响应返回期间占用，容量远大于 DRAMsim3 的事务队列深度；
+  // 表满时该 bank 暂停发读，等待响应释放表项
+  readMshrs.assign(num_banks, TransTable<int>(2 * buf_size));
+  nbrOutstandingReads.assign(num_banks, 0);
+  nbrOutstandingWrites.assign(num_banks, 0);
   // 初始化每个bank每个上游的重试标志
-  for (int bank = 0; bank < num_banks; bank++) {
-    for (int up = 0; up < num_upstreams; up++) {
-      response_retryReq[bank][up] = false;  // 请求重试标志
-      response_retryResp[bank][up] = false; // 响应重试标志
-    }
-  }
-  for (int bank = 0; bank < num_banks; bank++) {
-    request_retryReq[bank] = false;
-  }
+  response_retryReq.assign(num_banks, std::vector<bool>(num_upstreams, false));
+  response_retryResp.assign(num_banks, std::vector<bool>(num_upstreams, false));
+  request_retryReq.assign(num_banks, false);
+  write_draining_.assign(num_banks, false);
+  last_dir_.assign(num_banks, -1);
+  turnarounds_.assign(num_banks, 0);
+  drain_episodes_.assign(num_banks, 0);
 }
 
 void DramArb::allocateInputBuffers() {
@@ -60,6 +63,8 @@ void DramArb::allocateInputBuffers() {
     readInBufs[bank].resize(num_upstreams);  // 每个bank有num_upstreams个读队列
     writeInBufs[bank].resize(num_upstreams); // 每个bank有num_upstreams个写队列
   }
+  for (auto &since : headSince)
+    since.assign(num_banks, std::vector<Tick>(num_upstreams, 0));
 }
 
 void DramArb::initializeFifoServing() {
@@ -152,6 +157,42 @@ Port &DramArb::parseRequestPortName(const std::string &if_name) {
                            std::to_string(bank));
 }
 
+void DramArb::enableCreditFlow() {
+  // 每个 bank 的读/写输入缓冲各 buf_size 项，静态均分给各上游，
+  // 保证任意上游持信用发送时计数都不会超过 buf_size
+  int per_up = buf_size / num_upstreams;
+  assert(per_up > 0);
+  credit_flow_ = true;
+  for (int bank = 0; bank < num_banks; bank++)
+    for (int up = 0; up < num_upstreams; up++)
+      responsePorts[bank][up].grantCredits(per_up);
+  D_INFO("DRAM_ARB", "启用信用流控: 每个上游 %d 个信用", per_up);
+}
+
+void DramArb::trackRead(int bank, int upstream_id, PacketPtr pkt) {
+  // 发送前分配，调用前已确认表未满；DRAM 完成时把事务号带回响应包
+  int id = readMshrs[bank].alloc(upstream_id);
+  assert(id != TransTable<int>::kInvalid);
+  pkt->setTransId(id);
+}
+
+void DramArb::untrackRead(int bank, PacketPtr pkt) {
+  // 下游拒绝时撤销 trackRead，包留在输入缓冲中等待重试
+  readMshrs[bank].free(pkt->getTransId());
+  pkt->setTransId(-1);
+}
+
+void DramArb::recordIssue(int bank, int upstream_id, PacketPtr pkt) {
+  if (trace_)
+    trace_->record(curTick(), pkt->getAddr(), pkt->isWrite(), bank, upstream_id);
+}
+
+void DramArb::releaseInSlot(int bank, int upstream_id) {
+  // 请求离开输入缓冲后归还信用；重试模式下仍由仲裁处广播 sendRetryReq
+  if (credit_flow_)
+    responsePorts[bank][upstream_id].returnCredit();
+}
+
 // 兼容旧接口：默认使用上游0
 bool DramArb::recvTimingReq(PacketPtr pkt, int bank_id) {
   return recvTimingReqUp(pkt, bank_id, 0);
@@ -164,8 +205,8 @@ bool DramArb::recvTimingReqUp(PacketPtr pkt, int bank_id, int upstream_id) {
   assert(upstream_id >= 0 && upstream_id < num_upstreams);
   D_DEBUG("DRAM_ARB", "requst read data id :%d", upstream_id);
   // 检查是否可以接受新请求
-  bool can_accept_read = nbrOutstandingReads[bank_id] < buf_size;
-  bool can_accept_write = nbrOutstandingWrites[bank_id] < buf_size;
+  bool can_accept_read = nbrOutstandingReads[bank_id] < static_cast<unsigned>(buf_size);
+  bool can_accept_write = nbrOutstandingWrites[bank_id] < static_cast<unsigned>(buf_size);
 
   bool accepted = false;
 
@@ -174,11 +215,12 @@ bool DramArb::recvTimingReqUp(PacketPtr pkt, int bank_id, int upstream_id) {
     if (can_accept_read) {
       // 将请求放入对应上游的读缓冲区
       readInBufs[bank_id][upstream_id].push_back(pkt);
+      if (readInBufs[bank_id][upstream_id].size() == 1)
+        headSince[0][bank_id][upstream_id] = curTick();
       // 记录待响应的读请求
       // id_packet cam_readInf;
       // cam_readInf.upsteam_id = upstream_id;
       // cam_readInf.packets.push(pkt);
-      outstandingReads[bank_id][pkt->getAddr()].push(upstream_id);
       // outstandingUpstream[bank_id][pkt->getAddr()].push(upstream_id);
       nbrOutstandingReads[bank_id]++;
       accepted = true;
@@ -191,6 +233,8 @@ bool DramArb::recvTimingReqUp(PacketPtr pkt, int bank_id, int upstream_id) {
       // 处理写请求
       // if (nbrOutstandingWrites[bank_id] < (size_t)buf_size) {
       writeInBufs[bank_id][upstream_id].push_back(pkt);
+      if (writeInBufs[bank_id][upstream_id].size() == 1)
+        headSince[1][bank_id][upstream_id] = curTick();
       // 记录写请求的上游来源，用于写完成后的响应路由
       // id_packet cam_writeInf;
       // cam_writeInf.upsteam_id = upstream_id;
@@ -205,13 +249,16 @@ bool DramArb::recvTimingReqUp(PacketPtr pkt, int bank_id, int upstream_id) {
     }
   }
   if (accepted) {
+    if (interleave_)
+      pkt->setAddr(interleave_->toPhys(pkt->getAddr()));
     // 请求被接受，调度仲裁事件
     if (!arbEvent.scheduled()) {
       schedule(arbEvent, curTick() + 1);
     }
     return true;
   } else {
-    // 请求被拒绝，设置重试标志
+    // 请求被拒绝，设置重试标志（信用模式下上游持有信用才会发送，不应走到这里）
+    assert(!credit_flow_);
     response_retryReq[bank_id][upstream_id] = true;
     D_INFO("DRAM_ARB",
            "拒绝请求: bank=%d, upstream=%d, 读计数=%d, 写计数=%d, "
@@ -226,48 +273,46 @@ bool DramArb::recvTimingReqUp(PacketPtr pkt, int bank_id, int upstream_id) {
 bool DramArb::recvTimingResp(PacketPtr pkt, int bank_id) {
   assert(bank_id >= 0 && bank_id < num_banks);
 
-  addr_t addr = pkt->getAddr();
-  // // 查找对应的待响应读请求
-  // auto p = outstandingReads[bank_id].find(addr);
-  // assert(p != outstandingReads[bank_id].end());
-  // // 这是dram arb接受的addr
-  // delete p->second.front();
-  // p->second.pop();
-  // // 如果该地址没有更多待响应请求，清理记录
-  // if (p->second.empty()) {
-  //   outstandingReads[bank_id].erase(p); // 需要迭代器来删除
-  // }
   // 更新计数
     dram_burst_num++;
   if (pkt->isRead()) {
     // D_INFO("DRAM_ARB", "收到响应: addr=%d, bank=%d", addr, bank_id);
-    // 找到对应的上游编号
-    auto &qUp = outstandingReads[bank_id][addr];
-    assert(!qUp.empty());
-    int up = qUp.front();
-    qUp.pop();
-    // 如果该地址没有更多上游记录，清理
-    if (qUp.empty()) {
-      outstandingReads[bank_id].erase(addr); // 删除条目
-    }
+    // 按事务号找到对应的上游编号
+    int id = pkt->getTransId();
+    int up = readMshrs[bank_id][id];
+    bool was_full = readMshrs[bank_id].full();
+    readMshrs[bank_id].free(id);
+    pkt->setTransId(-1);
+    if (interleave_)
+      pkt->setAddr(interleave_->toLogical(pkt->getAddr()));
+    if (storage_)
+      storage_->readPacket(pkt);
     // 准备发送响应
     accessAndRespond(bank_id, pkt, up);
+    // 表满期间仲裁器已停止轮询该 bank 的读请求，腾出表项后唤醒
+    if (was_full && !arbEvent.scheduled())
+      schedule(arbEvent, curTick() + 1);
   } else {
-
-    // // 找到对应的上游编号
-    // auto &qUp = outstandingWrites[bank_id][addr];
-    // assert(!qUp.empty());
-    // up = qUp.front();
-    // qUp.pop();
-    // // 如果该地址没有更多上游记录，清理
-    // if (qUp.empty()) {
-    //   outstandingWrites[bank_id].erase(addr); // 删除条目
-    // }
     // D_INFO("BUG", "收到写响应，写入成功: bank=%d", bank_id);
   }
   return true;
 }
 
+void DramArb::recvFunctional(PacketPtr pkt, int bank_id) {
+  assert(bank_id >= 0 && bank_id < num_banks);
+  if (interleave_)
+    pkt->setAddr(interleave_->toPhys(pkt->getAddr()));
+  requestPorts[bank_id].sendFunctional(pkt);
+  if (interleave_)
+    pkt->setAddr(interleave_->toLogical(pkt->getAddr()));
+  // 与时序路径一致，只统计读响应的 burst 数
+  if (pkt->isRead()) {
+    dram_burst_num++;
+    if (storage_)
+      storage_->readPacket(pkt);
+  }
+}
+
 void DramArb::accessAndRespond(int bank_id, PacketPtr pkt, int upstream_id) {
   // 将响应包放入该 bank 的该上游队列
   responseQueues[bank_id][upstream_id].push_back(pkt);
@@ -341,17 +386,24 @@ void DramArb::arbitrate() {
     bool sent_this_bank = false;
 
     // 第一步：仲裁写请求（优先级高于读）
-    if (!request_retryReq[bank]) {
+    if (!request_retryReq[bank] && write_high_ > 0) {
+      arbitrateWithWatermarks(bank);
+    } else if (!request_retryReq[bank]) {
       sent_this_bank = arbitrateWriteRequests(bank);
-      // 第二步：如果读请求没有发送，仲裁写请求
-      if (!sent_this_bank)
-        arbitrateReadRequests(bank);
+      if (sent_this_bank)
+        noteIssue(bank, true);
+      // 第二步：如果写请求没有发送，仲裁读请求
+      else if (arbitrateReadRequests(bank))
+        noteIssue(bank, false);
     }
     // 检查是否还有待处理的请求
-    // 如果该bank未被下游阻塞，且仍有待处理请求，则需要继续调度
+    // 如果该bank未被下游阻塞，且仍有待处理请求，则需要继续调度；
+    // 读事务表满时读请求等 recvTimingResp 唤醒，不计入
     if ((!request_retryReq[bank])) {
+      bool reads_blocked = readMshrs[bank].full();
       for (int up = 0; up < num_upstreams; up++) {
-        if (!readInBufs[bank][up].empty() || !writeInBufs[bank][up].empty()) {
+        if ((!reads_blocked && !readInBufs[bank][up].empty()) ||
+            !writeInBufs[bank][up].empty()) {
           has_pending = true;
           break;
         }
@@ -365,7 +417,122 @@ void DramArb::arbitrate() {
   }
 }
 
+void DramArb::setWriteWatermarks(unsigned high, unsigned low) {
+  assert(high == 0 || (low < high && high <= static_cast<unsigned>(buf_size)));
+  write_high_ = high;
+  write_low_ = low;
+  D_INFO("DRAM_ARB", "写排空水位: high=%u, low=%u", high, low);
+}
+
+void DramArb::noteIssue(int bank, bool is_write) {
+  int dir = is_write ? 1 : 0;
+  if (last_dir_[bank] >= 0 && last_dir_[bank] != dir)
+    ++turnarounds_[bank];
+  last_dir_[bank] = dir;
+}
+
+void DramArb::arbitrateWithWatermarks(int bank) {
+  unsigned writes = nbrOutstandingWrites[bank];
+  bool reads_idle = nbrOutstandingReads[bank] == 0;
+
+  // 写队列达到高水位，或读空闲时顺带清空积压的写
+  if (!write_draining_[bank] && writes > 0 &&
+      (writes >= write_high_ || reads_idle)) {
+    write_draining_[bank] = true;
+    ++drain_episodes_[bank];
+    D_INFO("DRAM_ARB", "开始写排空: bank=%d, 写计数=%u", bank, writes);
+  }
+
+  if (write_draining_[bank]) {
+    if (arbitrateWriteRequests(bank))
+      noteIssue(bank, true);
+    writes = nbrOutstandingWrites[bank];
+    // 读空闲时继续排空，有读等待时排到低水位即切回
+    if (writes == 0 || (writes <= write_low_ && !reads_idle)) {
+      write_draining_[bank] = false;
+      D_INFO("DRAM_ARB", "结束写排空: bank=%d, 写计数=%u", bank, writes);
+    }
+    return;
+  }
+
+  if (arbitrateReadRequests(bank))
+    noteIssue(bank, false);
+}
+
+void DramArb::printStats(std::ostream &os) const {
+  uint64_t total_turn = 0, total_drain = 0;
+  for (int bank = 0; bank < num_banks; bank++) {
+    total_turn += turnarounds_[bank];
+    total_drain += drain_episodes_[bank];
+  }
+  os << "DramArb: write_high=" << write_high_ << " write_low=" << write_low_
+     << " turnarounds=" << total_turn << " drain_episodes=" << total_drain
+     << std::endl;
+  for (int bank = 0; bank < num_banks; bank++)
+    os << "  bank" << bank << ": turnarounds=" << turnarounds_[bank]
+       << " drain_episodes=" << drain_episodes_[bank] << std::endl;
+}
+
+void DramArb::serialize(SectionOut &os) const {
+  os.put(static_cast<int32_t>(num_banks));
+  os.put(static_cast<int32_t>(num_upstreams));
+  for (const TransTable<int> &mshr : readMshrs)
+    mshr.serialize(os);
+  os.put(nbrOutstandingReads);
+  os.put(nbrOutstandingWrites);
+  os.put(readInBufs);
+  os.put(writeInBufs);
+  os.put(headSince[0]);
+  os.put(headSince[1]);
+  os.put(responseQueues);
+  os.put(response_retryReq);
+  os.put(response_retryResp);
+  os.put(request_retryReq);
+  os.put(write_draining_);
+  os.put(last_dir_);
+  os.put(turnarounds_);
+  os.put(drain_episodes_);
+  os.put(currentServingReadUpstream);
+  os.put(currentServingWriteUpstream);
+  // 全局 burst 计数由本模块累加
+  os.put(dram_burst_num);
+  if (policy_)
+    policy_->serialize(os);
+}
+
+void DramArb::unserialize(SectionIn &is) {
+  if (is.get<int32_t>() != num_banks || is.get<int32_t>() != num_upstreams)
+    throw std::runtime_error(name() + ": checkpoint bank/upstream count mismatch");
+  for (TransTable<int> &mshr : readMshrs)
+    mshr.unserialize(is);
+  is.get(nbrOutstandingReads);
+  is.get(nbrOutstandingWrites);
+  is.get(readInBufs);
+  is.get(writeInBufs);
+  is.get(headSince[0]);
+  is.get(headSince[1]);
+  is.get(responseQueues);
+  is.get(response_retryReq);
+  is.get(response_retryResp);
+  is.get(request_retryReq);
+  is.get(write_draining_);
+  is.get(last_dir_);
+  is.get(turnarounds_);
+  is.get(drain_episodes_);
+  is.get(currentServingReadUpstream);
+  is.get(currentServingWriteUpstream);
+  is.get(dram_burst_num);
+  if (policy_)
+    policy_->unserialize(is);
+}
+
 bool DramArb::arbitrateReadRequests(int bank) {
+  if (policy_)
+    return arbitrateByPolicy(bank, false);
+  // 读事务表满，等响应释放表项后再发
+  if (readMshrs[bank].full())
+    return false;
+
   // 基于FIFO数据量的仲裁策略：持续服务当前FIFO直到为空
   int serving_upstream = currentServingReadUpstream[bank];
 
@@ -373,12 +540,14 @@ bool DramArb::arbitrateReadRequests(int bank) {
   if (serving_upstream >= 0 && !readInBufs[bank][serving_upstream].empty()) {
     PacketPtr pkt = readInBufs[bank][serving_upstream].front();
 
+    trackRead(bank, serving_upstream, pkt);
     if (requestPorts[bank].sendTimingReq(pkt)) {
       // 发送成功
-
       assert(nbrOutstandingReads[bank] > 0);
       --nbrOutstandingReads[bank];
       readInBufs[bank][serving_upstream].pop_front();
+      releaseInSlot(bank, serving_upstream);
+      recordIssue(bank, serving_upstream, pkt);
       D_DEBUG("DRAM_ARB", "发送出去的ADDR:%d", pkt->getAddr());
       D_INFO("DRAM_ARB", "继续服务读FIFO: bank=%d, upstream=%d, 剩余=%zu", bank,
              serving_upstream, readInBufs[bank][serving_upstream].size());
@@ -403,6 +572,7 @@ bool DramArb::arbitrateReadRequests(int bank) {
     } else {
       // 发送失败，保持当前服务状态，等待重试。
       // 一次失败后，该bank整体不再仲裁，直至handleReqRetry清除阻塞。
+      untrackRead(bank, pkt);
       request_retryReq[bank] = true;
       D_INFO("DRAM_ARB", "读请求发送失败: bank=%d, upstream=%d", bank,
              serving_upstream);
@@ -436,6 +606,7 @@ bool DramArb::arbitrateReadRequests(int bank) {
   if (max_upstream >= 0) {
     PacketPtr pkt = readInBufs[bank][max_upstream].front();
 
+    trackRead(bank, max_upstream, pkt);
     if (requestPorts[bank].sendTimingReq(pkt)) {
       // 发送成功
       // 当fifo有位置了，就通知所有上游buf，不然可能会漏掉
@@ -450,6 +621,8 @@ bool DramArb::arbitrateReadRequests(int bank) {
       assert(nbrOutstandingReads[bank] > 0);
       --nbrOutstandingReads[bank];
       readInBufs[bank][max_upstream].pop_front();
+      releaseInSlot(bank, max_upstream);
+      recordIssue(bank, max_upstream, pkt);
       D_DEBUG("DRAM_ARB", "发送出去的ADDR:%d", pkt->getAddr());
       currentServingReadUpstream[bank] = max_upstream; // 设置当前服务的FIFO
 
@@ -466,6 +639,7 @@ bool DramArb::arbitrateReadRequests(int bank) {
       return true; // 该bank本轮已发送
     } else {
       // 发送失败后，阻塞该bank的读写仲裁
+      untrackRead(bank, pkt);
       request_retryReq[bank] = true;
       D_INFO("DRAM_ARB", "读请求发送失败: bank=%d, upstream=%d", bank,
              max_upstream);
@@ -477,6 +651,8 @@ bool DramArb::arbitrateReadRequests(int bank) {
 }
 
 bool DramArb::arbitrateWriteRequests(int bank) {
+  if (policy_)
+    return arbitrateByPolicy(bank, true);
   // 基于FIFO数据量的仲裁策略：持续服务当前FIFO直到为空
   int serving_upstream = currentServingWriteUpstream[bank];
 
@@ -489,6 +665,8 @@ bool DramArb::arbitrateWriteRequests(int bank) {
       assert(nbrOutstandingWrites[bank] > 0);
       --nbrOutstandingWrites[bank];
       writeInBufs[bank][serving_upstream].pop_front();
+      releaseInSlot(bank, serving_upstream);
+      recordIssue(bank, serving_upstream, pkt);
 
     D_INFO("DRAM_ARB", "继续服务写FIFO: bank=%d, upstream=%d, 剩余=%zu", bank,
              serving_upstream, writeInBufs[bank][serving_upstream].size());
@@ -551,6 +729,8 @@ bool DramArb::arbitrateWriteRequests(int bank) {
       assert(nbrOutstandingWrites[bank] > 0);
       --nbrOutstandingWrites[bank];
       writeInBufs[bank][max_upstream].pop_front();
+      releaseInSlot(bank, max_upstream);
+      recordIssue(bank, max_upstream, pkt);
       currentServingWriteUpstream[bank] = max_upstream; // 设置当前服务的FIFO
 
       D_INFO("DRAM_ARB",
@@ -585,6 +765,48 @@ bool DramArb::arbitrateWriteRequests(int bank) {
   return false;
 }
 
+bool DramArb::arbitrateByPolicy(int bank, bool is_write) {
+  auto &bufs = is_write ? writeInBufs[bank] : readInBufs[bank];
+  if (!is_write && readMshrs[bank].full())
+    return false;
+  int up = policy_->pick(bank, is_write, bufs);
+  if (up < 0)
+    return false;
+  PacketPtr pkt = bufs[up].front();
+
+  if (!is_write)
+    trackRead(bank, up, pkt);
+  if (!requestPorts[bank].sendTimingReq(pkt)) {
+    // 发送失败，阻塞该bank的读写仲裁，等待 handleReqRetry
+    if (!is_write)
+      untrackRead(bank, pkt);
+    request_retryReq[bank] = true;
+    D_INFO("DRAM_ARB", "%s请求发送失败: bank=%d, upstream=%d",
+           is_write ? "写" : "读", bank, up);
+    return false;
+  }
+
+  Tick &since = headSince[is_write][bank][up];
+  policy_->issued(bank, is_write, up, curTick() - since, bufs);
+  auto &outstanding = is_write ? nbrOutstandingWrites[bank] : nbrOutstandingReads[bank];
+  assert(outstanding > 0);
+  --outstanding;
+  bufs[up].pop_front();
+  since = curTick(); // 下一个包从此刻起成为队首
+  releaseInSlot(bank, up);
+  recordIssue(bank, up, pkt);
+  // 每发送一个请求都腾出一个位置，通知所有等待重试的上游
+  for (int i = 0; i < num_upstreams; i++) {
+    if (response_retryReq[bank][i]) {
+      responsePorts[bank][i].sendRetryReq();
+      response_retryReq[bank][i] = false;
+    }
+  }
+  D_INFO("DRAM_ARB", "%s: bank=%d, upstream=%d, addr=%d", policy_->name(), bank,
+         up, pkt->getAddr());
+  return true;
+}
+
 void DramArb::scheduleArbEvent(int bank) {
   // 预留接口：可以在这里添加特定bank的仲裁调度逻辑
 }
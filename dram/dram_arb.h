@@ -16,9 +16,14 @@
 
 #include "common/packet.h"
 #include "common/port.h"
+#include "common/trans_table.h"
+#include "dram/arb_policy.h"
+#include "dram/dram_trace.h"
 #include "dram/dramsim3.h"
 #include "event/eventq.h"
 #include <deque>
+#include <memory>
+#include <ostream>
 #include <queue>
 #include <string>
 #include <unordered_map>
@@ -26,6 +31,7 @@
 
 namespace GNN
 {
+  class SimDramStorage;
   struct id_packet {
     int upsteam_id;
     std::queue<PacketPtr> packets;
@@ -34,24 +40,47 @@ namespace GNN
   class DramArb : public SimObject
   {
   public:
-    static constexpr int num_banks = 8;
-    static constexpr int num_up = 6; // allow one extra upstream for DMA
-    // 多上游数量可配置，默认1保持兼容
-    DramArb(const std::string &_name, int buf_size, int num_upstreams_ = 1);
+    // 多上游数量可配置，默认1保持兼容；通道(bank)数运行时指定
+    DramArb(const std::string &_name, int buf_size, int num_upstreams_ = 1,
+            int num_banks_ = CHANNEL_NUM);
     void init() override {}
-    // CAM表：addr -> 多个等待响应的请求
-    std::unordered_map<addr_t, std::queue<int>> outstandingReads[num_banks];
-    unsigned int nbrOutstandingReads[num_banks];
-
-    std::unordered_map<addr_t, std::queue<int>> outstandingWrites[num_banks];
-    unsigned int nbrOutstandingWrites[num_banks];
-    // 响应缓存队列（每个bank一个）
-    std::deque<PacketPtr> respQueue[num_banks];
+    int numBanks() const { return num_banks; }
+    // 改用信用流控：输入缓冲按上游均分为信用通告给上游，上游不再被拒绝，
+    // 请求转发到 DRAM 后归还信用。需在端口绑定之后调用
+    void enableCreditFlow();
+    bool creditFlow() const { return credit_flow_; }
+    // 替换仲裁策略；未设置时沿用内置的"持续服务编号最小的非空FIFO直至排空"
+    void setArbPolicy(std::unique_ptr<ArbPolicy> policy) { policy_ = std::move(policy); }
+    const ArbPolicy *arbPolicy() const { return policy_.get(); }
+    // 地址交织：请求进入输入缓冲时换成 DRAM 物理地址，读响应回上游前换回逻辑地址，
+    // 仲裁策略与 DRAM 后端看到的都是物理地址。未设置时地址原样转发
+    void setAddrInterleave(const AddrInterleave *interleave) { interleave_ = interleave; }
+    // 记录每个发往 DRAM 的事务（tick、物理地址、读写、上游），供 DramTraceReplay 回放
+    void setTrace(DramTraceWriter *trace) { trace_ = trace; }
+    // 读响应（含功能访问）回上游前按逻辑地址从存储取数填入包内，下游直接使用包中数据。
+    // 未设置时响应只有时序、不带数据
+    void setStorage(SimDramStorage *storage) { storage_ = storage; }
+    // 写排空水位：写请求攒到 high 或读空闲时才集中发送，排到 low 以下切回读。
+    // high 为 0 时保持原来的写严格优先
+    void setWriteWatermarks(unsigned high, unsigned low);
+    // 每个 bank 的读写切换次数与写排空次数
+    void printStats(std::ostream &os) const;
+    // 检查点：输入缓冲、读事务表、响应队列与仲裁策略状态
+    void serialize(SectionOut &os) const override;
+    void unserialize(SectionIn &is) override;
+    // 已发往 DRAM 的读事务表：事务号 -> 来源上游，响应按包内事务号路由；
+    // 表满时仲裁器不再为读请求逐周期轮询，由释放表项的响应唤醒
+    std::vector<TransTable<int>> readMshrs; // [bank]
+    // 输入缓冲中尚未发出的读/写请求数
+    std::vector<unsigned int> nbrOutstandingReads;
+    std::vector<unsigned int> nbrOutstandingWrites;
 
     // 输入缓冲：按 bank 和上游编号分布
     // 读/写各自维护一套，以便不同优先级策略
     std::vector<std::vector<std::deque<PacketPtr>>> readInBufs;  // [bank][up]
     std::vector<std::vector<std::deque<PacketPtr>>> writeInBufs; // [bank][up]
+    // 各输入队列当前队首成为队首的时刻，入空队列或前一个出队时记录
+    std::vector<std::vector<Tick>> headSince[2]; // [is_write][bank][up]
 
     // 端口
     class ArbResponsePort : public ResponsePort
@@ -70,6 +99,7 @@ namespace GNN
         return arb.recvTimingReqUp(pkt, bank_id, upstream_id);
       }
       void recvRespRetry() override { arb.handleRespRetry(bank_id, upstream_id); }
+      void recvFunctional(PacketPtr pkt) override { arb.recvFunctional(pkt, bank_id); }
     };
     class ArbRequestPort : public RequestPort
     {
@@ -97,6 +127,8 @@ namespace GNN
     // 新接口：携带上游编号
     bool recvTimingReqUp(PacketPtr pkt, int bank_id, int upstream_id);
     bool recvTimingResp(PacketPtr pkt, int bank_id);
+    // 功能访问：绕过输入缓冲与仲裁，直接转发到对应 bank 的 DRAM
+    void recvFunctional(PacketPtr pkt, int bank_id);
 
     void arbitrate();
     void scheduleArbEvent(int bank);
@@ -106,19 +138,32 @@ namespace GNN
     void sendResponse();
 
   private:
+    // 构造时先于事件初始化
+    int buf_size;
+    int num_upstreams;
+    int num_banks;
     // 发送响应事件
-    EventFunctionWrapper sendResponseEvent;
-    EventFunctionWrapper arbEvent;
+    MemberEventWrapper<&DramArb::sendResponse> sendResponseEvent;
+    MemberEventWrapper<&DramArb::arbitrate> arbEvent;
     //之前是所有upstream流向同一个fifo
     // std::deque<std::pair<PacketPtr, int>> responseQueue[num_banks];
        // 每个 bank、每个上游的响应队列
    std::vector<std::vector<std::deque<PacketPtr>>> responseQueues;
-    int buf_size;
-    bool response_retryReq[num_banks][num_up];  // 记录每个bank是否等待发送请求的重试
-    bool response_retryResp[num_banks][num_up]; // 记录每个bank是否等待发送响应的重试
-
-    bool request_retryReq[num_banks];
-    int num_upstreams;
+    std::vector<std::vector<bool>> response_retryReq;  // [bank][up] 记录每个bank是否等待发送请求的重试
+    std::vector<std::vector<bool>> response_retryResp; // [bank][up] 记录每个bank是否等待发送响应的重试
+
+    std::vector<bool> request_retryReq; // [bank]
+    bool credit_flow_ = false;
+    std::unique_ptr<ArbPolicy> policy_;
+    const AddrInterleave *interleave_ = nullptr;
+    DramTraceWriter *trace_ = nullptr;
+    SimDramStorage *storage_ = nullptr;
+    unsigned write_high_ = 0;
+    unsigned write_low_ = 0;
+    std::vector<bool> write_draining_;        // [bank]
+    std::vector<int> last_dir_;               // [bank] -1 未发送, 0 读, 1 写
+    std::vector<uint64_t> turnarounds_;       // [bank]
+    std::vector<uint64_t> drain_episodes_;    // [bank]
     // // 注意：不再使用轮询指针，改为基于FIFO数据量的仲裁策略
     // // 记录每个读请求的来源上游（与 outstandingReads 同步）
     // std::unordered_map<addr_t, std::queue<int>> outstandingUpstreamRead[num_banks];
@@ -138,6 +183,13 @@ namespace GNN
     Port &parseRequestPortName(const std::string &if_name);
     bool arbitrateReadRequests(int bank);
     bool arbitrateWriteRequests(int bank);
+    bool arbitrateByPolicy(int bank, bool is_write);
+    void arbitrateWithWatermarks(int bank);
+    void noteIssue(int bank, bool is_write);
+    void releaseInSlot(int bank, int upstream_id);
+    void recordIssue(int bank, int upstream_id, PacketPtr pkt);
+    void trackRead(int bank, int upstream_id, PacketPtr pkt);
+    void untrackRead(int bank, PacketPtr pkt);
 
   };
 
@@ -0,0 +1,190 @@
+#include "dram/dram_trace.h"
+#include "dram/dramsim3_wrapper.h"
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace GNN {
+
+static const char kTraceMagic[8] = {'G', 'N', 'N', 'D', 'T', 'R', 'C', '1'};
+static constexpr size_t kFlushBytes = 1 << 16;
+
+static uint64_t zigzag(int64_t v) {
+  return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+static int64_t unzigzag(uint64_t v) {
+  return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+// ---------------- 写轨迹 ----------------
+
+DramTraceWriter::DramTraceWriter(const std::string &path, int channels)
+    : out(path, std::ios::binary), last_addr(channels, 0) {
+  if (!out)
+    throw std::runtime_error("cannot write dram trace: " + path);
+  uint32_t ch = static_cast<uint32_t>(channels);
+  out.write(kTraceMagic, sizeof(kTraceMagic));
+  out.write(reinterpret_cast<const char *>(&ch), sizeof(ch));
+  num_bytes = sizeof(kTraceMagic) + sizeof(ch);
+  buf.reserve(kFlushBytes + 32);
+}
+
+void DramTraceWriter::putVarint(uint64_t v) {
+  while (v >= 0x80) {
+    buf.push_back(static_cast<char>((v & 0x7f) | 0x80));
+    v >>= 7;
+  }
+  buf.push_back(static_cast<char>(v));
+}
+
+void DramTraceWriter::record(Tick tick, uint64_t addr, bool is_write, int bank,
+                             int upstream) {
+  assert(bank >= 0 && static_cast<size_t>(bank) < last_addr.size());
+  assert(upstream >= 0 && upstream < 8 && tick >= last_tick);
+  putVarint(tick - last_tick);
+  putVarint((static_cast<uint64_t>(bank) << 4) |
+            (static_cast<uint64_t>(upstream) << 1) | (is_write ? 1 : 0));
+  putVarint(zigzag(static_cast<int64_t>(addr - last_addr[bank])));
+  last_tick = tick;
+  last_addr[bank] = addr;
+  ++num_records;
+  if (buf.size() >= kFlushBytes)
+    flush();
+}
+
+void DramTraceWriter::flush() {
+  out.write(buf.data(), buf.size());
+  num_bytes += buf.size();
+  buf.clear();
+}
+
+void DramTraceWriter::close() {
+  if (!out.is_open())
+    return;
+  flush();
+  out.close();
+}
+
+// ---------------- 读轨迹 ----------------
+
+DramTraceReader::DramTraceReader(const std::string &path)
+    : in(path, std::ios::binary) {
+  if (!in)
+    throw std::runtime_error("cannot open dram trace: " + path);
+  char magic[sizeof(kTraceMagic)];
+  uint32_t ch = 0;
+  in.read(magic, sizeof(magic));
+  in.read(reinterpret_cast<char *>(&ch), sizeof(ch));
+  if (!in || std::memcmp(magic, kTraceMagic, sizeof(magic)) != 0 || ch == 0)
+    throw std::runtime_error("not a dram trace: " + path);
+  num_channels = static_cast<int>(ch);
+  last_addr.assign(num_channels, 0);
+}
+
+bool DramTraceReader::getVarint(uint64_t &v) {
+  v = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    int c = in.get();
+    if (c == std::char_traits<char>::eof())
+      return false;
+    v |= static_cast<uint64_t>(c & 0x7f) << shift;
+    if (!(c & 0x80))
+      return true;
+  }
+  throw std::runtime_error("corrupt dram trace");
+}
+
+bool DramTraceReader::next(DramTraceRecord &rec) {
+  uint64_t dtick, flags, daddr;
+  if (!getVarint(dtick))
+    return false;
+  if (!getVarint(flags) || !getVarint(daddr))
+    throw std::runtime_error("truncated dram trace");
+  int bank = static_cast<int>(flags >> 4);
+  if (bank >= num_channels)
+    throw std::runtime_error("corrupt dram trace");
+  last_tick += dtick;
+  last_addr[bank] += static_cast<uint64_t>(unzigzag(daddr));
+  rec.tick = last_tick;
+  rec.addr = last_addr[bank];
+  rec.is_write = flags & 1;
+  rec.bank = bank;
+  rec.upstream = static_cast<int>((flags >> 1) & 7);
+  return true;
+}
+
+// ---------------- 回放 ----------------
+
+DramTraceReplay::DramTraceReplay(const std::string &name_,
+                                 const std::string &path,
+                                 dramsim3_wrapper *wrapper)
+    : SimObject(name_), reader(path), wrapper(wrapper),
+      pending(reader.channels()), issueEvent(*this, "issueEvent") {
+  for (int ch = 0; ch < reader.channels(); ++ch) {
+    wrapper->set_read_callback(ch, [this](PacketPtr pkt) { complete(pkt); });
+    wrapper->set_write_callback(ch, [this](PacketPtr pkt) { complete(pkt); });
+  }
+}
+
+void DramTraceReplay::init() {
+  have_lookahead = reader.next(lookahead);
+  if (have_lookahead)
+    schedule(issueEvent, lookahead.tick);
+}
+
+void DramTraceReplay::issue() {
+  while (have_lookahead && lookahead.tick <= curTick()) {
+    pending[lookahead.bank].push_back(lookahead);
+    last_record = lookahead.tick;
+    have_lookahead = reader.next(lookahead);
+  }
+  bool stalled = false;
+  for (auto &q : pending) {
+    while (!q.empty()) {
+      const DramTraceRecord &rec = q.front();
+      if (!wrapper->can_accept(rec.addr, rec.is_write)) {
+        stalled = true;
+        break;
+      }
+      PacketPtr pkt =
+          rec.is_write
+              ? PacketManager::create_write_packet(rec.addr, BURST_BITS / STORAGE_SIZE)
+              : PacketManager::create_read_packet(rec.addr, BURST_BITS / STORAGE_SIZE);
+      issued_at[pkt] = curTick();
+      delayed_ticks += curTick() - rec.tick;
+      ++(rec.is_write ? num_writes : num_reads);
+      wrapper->send_request(pkt);
+      q.pop_front();
+    }
+  }
+  // DRAMsim3 不接收时逐周期重试，否则直接跳到下一条记录的时刻
+  if (stalled)
+    schedule(issueEvent, curTick() + 1);
+  else if (have_lookahead)
+    schedule(issueEvent, lookahead.tick);
+}
+
+void DramTraceReplay::complete(PacketPtr pkt) {
+  auto it = issued_at.find(pkt);
+  assert(it != issued_at.end());
+  total_latency += curTick() - it->second;
+  issued_at.erase(it);
+  ++completed;
+  last_complete = curTick();
+  PacketManager::free_packet(pkt);
+}
+
+void DramTraceReplay::report(std::ostream &os) const {
+  os << "DramTraceReplay: reads=" << num_reads << " writes=" << num_writes
+     << " completed=" << completed << " last_record=" << last_record
+     << " last_complete=" << last_complete;
+  if (completed > 0)
+    os << " mean_latency=" << double(total_latency) / completed;
+  if (num_reads + num_writes > 0)
+    os << " mean_issue_delay="
+       << double(delayed_ticks) / (num_reads + num_writes);
+  os << std::endl;
+}
+
+} // namespace GNN
@@ -0,0 +1,105 @@
+#ifndef GNN_DRAM_DRAM_TRACE_H_
+#define GNN_DRAM_DRAM_TRACE_H_
+
+#include "common/define.h"
+#include "common/object.h"
+#include "common/packet.h"
+#include "event/eventq.h"
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace GNN {
+
+class dramsim3_wrapper;
+
+// DRAM 请求轨迹：DramArb 每发出一个事务记一条，地址为送往 DRAM 的物理地址。
+// 文件头为 8 字节魔数与通道数，之后每条记录三个 LEB128 变长整数：
+//   与上一条的 tick 差；(bank << 4) | (upstream << 1) | is_write；
+//   与同 bank 上一条地址之差（zigzag 编码）。
+// 单个 bank 的请求基本按固定步长推进，一条记录通常只占 4~5 字节
+struct DramTraceRecord {
+  Tick tick;
+  uint64_t addr;
+  bool is_write;
+  int bank;
+  int upstream;
+};
+
+class DramTraceWriter {
+public:
+  // 文件无法创建时抛出 std::runtime_error
+  DramTraceWriter(const std::string &path, int channels);
+  ~DramTraceWriter() { close(); }
+  void record(Tick tick, uint64_t addr, bool is_write, int bank, int upstream);
+  void close();
+  uint64_t records() const { return num_records; }
+  uint64_t bytes() const { return num_bytes; }
+
+private:
+  void putVarint(uint64_t v);
+  void flush();
+
+  std::ofstream out;
+  std::vector<char> buf;
+  Tick last_tick = 0;
+  std::vector<uint64_t> last_addr; // [bank]
+  uint64_t num_records = 0;
+  uint64_t num_bytes = 0;
+};
+
+class DramTraceReader {
+public:
+  // 文件不存在或不是 DRAM 轨迹时抛出 std::runtime_error
+  explicit DramTraceReader(const std::string &path);
+  int channels() const { return num_channels; }
+  // 读到文件尾返回 false；记录被截断时抛出 std::runtime_error
+  bool next(DramTraceRecord &rec);
+
+private:
+  bool getVarint(uint64_t &v);
+
+  std::ifstream in;
+  int num_channels = 0;
+  Tick last_tick = 0;
+  std::vector<uint64_t> last_addr; // [bank]
+};
+
+// 轨迹回放：不构建 DMA/解码器/仲裁器，按记录的 tick 把事务直接交给 dramsim3_wrapper。
+// 每个 bank 按记录顺序发送，DRAMsim3 不接收时该 bank 顺延，其余 bank 不受影响
+class DramTraceReplay : public SimObject {
+public:
+  DramTraceReplay(const std::string &name_, const std::string &path,
+                  dramsim3_wrapper *wrapper);
+  void init() override;
+  int channels() const { return reader.channels(); }
+  void report(std::ostream &os) const;
+
+private:
+  void issue();
+  void complete(PacketPtr pkt);
+
+  DramTraceReader reader;
+  dramsim3_wrapper *wrapper;
+  DramTraceRecord lookahead{};
+  bool have_lookahead = false;
+  std::vector<std::deque<DramTraceRecord>> pending; // [bank]
+  std::unordered_map<PacketPtr, Tick> issued_at;
+  MemberEventWrapper<&DramTraceReplay::issue> issueEvent;
+
+  uint64_t num_reads = 0;
+  uint64_t num_writes = 0;
+  uint64_t completed = 0;
+  Tick delayed_ticks = 0; // 实际发出时刻晚于记录时刻的累计值
+  Tick total_latency = 0;
+  Tick last_record = 0;
+  Tick last_complete = 0;
+};
+
+} // namespace GNN
+
+#endif // GNN_DRAM_DRAM_TRACE_H_
@@ -1,5 +1,6 @@
 
 #include "dram/dramsim3.h"
+#include "dram/analytic_dram.h"
 
 namespace GNN {
 DRAMsim3::DRAMsim3(const std::string &name_, int channel,
@@ -7,8 +8,8 @@ DRAMsim3::DRAMsim3(const std::string &name_, int channel,
     : SimObject(name_), port(name() + ".port", *this), channel_id(channel),
       wrapper(wrapper), retryReq(false), retryResp(false), startTick(0),
       nbrOutstandingReads(0), nbrOutstandingWrites(0),
-      sendResponseEvent([this] { sendResponse(); }, name()),
-      tickEvent([this] { tick(); }, name()) {
+      sendResponseEvent(*this, "sendResponseEvent"),
+      tickEvent(*this, "tickEvent") {
   wrapper->set_read_callback(
       channel_id, [this](PacketPtr pkt) { this->readComplete(pkt); }),
   wrapper->set_write_callback(
@@ -35,6 +36,19 @@ void DRAMsim3::resetStats() {
   // wrapper->resetStats();
 }
 
+void DRAMsim3::serialize(SectionOut &os) const {
+  assert(nbrOutstanding() == 0 && responseQueue.empty());
+  os.put(retryReq);
+  os.put(retryResp);
+  os.put(startTick);
+}
+
+void DRAMsim3::unserialize(SectionIn &is) {
+  is.get(retryReq);
+  is.get(retryResp);
+  is.get(startTick);
+}
+
 void DRAMsim3::sendResponse() {
   assert(!retryResp);
   assert(!responseQueue.empty());
@@ -43,6 +57,9 @@ void DRAMsim3::sendResponse() {
 
   if (success) {
     responseQueue.pop_front();
+    // 同一周期可能有多个完成，每周期发送一个直至排空
+    if (!responseQueue.empty() && !sendResponseEvent.scheduled())
+      schedule(sendResponseEvent, curTick() + 1);
   } else {
     retryResp = true;
   }
@@ -68,18 +85,16 @@ bool DRAMsim3::recvTimingReq(PacketPtr pkt) {
   // keep track of the transaction
   bool can_accept = wrapper->can_accept(pkt->getAddr(), pkt->isWrite());
   if (can_accept){
-    if (!pkt->isWrite()) {
-      outstandingReads[pkt->getAddr()].push(pkt);
+    if (!pkt->isWrite())
       ++nbrOutstandingReads;
-
-    } else {
-      outstandingWrites[pkt->getAddr()].push(pkt);
+    else
       ++nbrOutstandingWrites;
-    }
   }
   D_INFO("DRAM_SIM3", "accept addr : %d  can_accept: %d   pkt->isWrite() : %d",pkt->getAddr(), can_accept, pkt->isWrite());
   if (can_accept) {
-    wrapper->send_request(pkt->getAddr(), pkt->isWrite());
+    if (calibration)
+      calibration->accept(channel_id, pkt, curTick());
+    wrapper->send_request(pkt);
     return true;
   } else {
     retryReq = true;
@@ -89,6 +104,13 @@ bool DRAMsim3::recvTimingReq(PacketPtr pkt) {
   }
 }
 
+void DRAMsim3::recvFunctional(PacketPtr pkt) {
+  // 功能访问：不进入 DRAMsim3 时序模型，不占用事务队列。
+  // 数据本身由 SimDramStorage 按地址提供，这里只需应答
+  D_INFO("DRAM_SIM3", "functional %s addr: %d, channel_id: %d",
+         pkt->isWrite() ? "write" : "read", pkt->getAddr(), channel_id);
+}
+
 void DRAMsim3::recvRespRetry() // 被调用上游
 {
   // DPRINTF(DRAMsim3, "Retrying\n");
@@ -112,16 +134,9 @@ void DRAMsim3::accessAndRespond(PacketPtr pkt) {
 void DRAMsim3::readComplete(PacketPtr pkt) {
   D_INFO("DRAM_SIM3", "[Recv DRAMSIM3],channel_id: %d,readComplete addr: %lld",
          channel_id, pkt->getAddr());
-  // get the outstanding reads for the address in question
-  auto p = outstandingReads.find(pkt->getAddr());
-  assert(p != outstandingReads.end());
-  // first in first out, which is not necessarily true, but it is
-  // the best we can do at this point
-
-  p->second.pop();
-  if (p->second.empty())
-    outstandingReads.erase(
-        p); // 会删除map中的条目，释放相关内存 这个条目对应的内存
+  // wrapper 交回的就是原请求包，事务号等元信息原样带回，直接作为响应
+  if (calibration)
+    calibration->complete(channel_id, pkt, curTick());
 
   // no need to check for drain here as the next call will add a
   // response to the response queue straight away
@@ -140,12 +155,8 @@ void DRAMsim3::readComplete(PacketPtr pkt) {
 void DRAMsim3::writeComplete(PacketPtr pkt) {
   D_INFO("DRAM_SIM3", "[Recv DRAMSIM3],channel_id: %d,writeComplete addr: %lld",
          channel_id, pkt->getAddr());
-  auto p = outstandingWrites.find(pkt->getAddr());
-  assert(p != outstandingWrites.end());
-
-  p->second.pop();
-  if (p->second.empty())
-    outstandingWrites.erase(p);
+  if (calibration)
+    calibration->complete(channel_id, pkt, curTick());
   assert(nbrOutstandingWrites != 0);
   --nbrOutstandingWrites;
 
@@ -155,6 +166,8 @@ void DRAMsim3::writeComplete(PacketPtr pkt) {
 
   // perform the actual memory access
   // accessAndRespond(pkt);
+  // 写完成不回响应，原请求包到此结束生命周期
+  PacketManager::free_packet(pkt);
 }
 
 DRAMsim3::MemoryPort::MemoryPort(const std::string &_name, DRAMsim3 &_memory)
@@ -166,5 +179,9 @@ bool DRAMsim3::MemoryPort::recvTimingReq(PacketPtr pkt) {
   return mem.recvTimingReq(pkt);
 }
 
+void DRAMsim3::MemoryPort::recvFunctional(PacketPtr pkt) {
+  mem.recvFunctional(pkt);
+}
+
 void DRAMsim3::MemoryPort::recvRespRetry() { mem.recvRespRetry(); }
 } // namespace GNN
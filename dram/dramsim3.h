@@ -18,6 +18,7 @@
 namespace GNN
 {
   // DRAMsim3 内存控制器类
+  class DramCalibration;
   class DRAMsim3 : public SimObject
   {
   public:
@@ -47,7 +48,7 @@ namespace GNN
       MemoryPort(const std::string &_namer, DRAMsim3 &_memory);
 
     protected:
-      void recvFunctional(PacketPtr pkt);
+      void recvFunctional(PacketPtr pkt) override;
       bool recvTimingReq(PacketPtr pkt);
       void recvRespRetry() override;
     };
@@ -61,9 +62,6 @@ namespace GNN
     bool retryResp;
     // 记录 wrapper 启动时刻
     cycle_t startTick;
-    // 记录每个地址未完成的读写事务队列
-    std::unordered_map<addr_t, std::queue<PacketPtr>> outstandingReads;
-    std::unordered_map<addr_t, std::queue<PacketPtr>> outstandingWrites;
     // 统计未完成的事务数，用于流控
     unsigned int nbrOutstandingReads;
     unsigned int nbrOutstandingWrites;
@@ -71,15 +69,16 @@ namespace GNN
     std::deque<PacketPtr> responseQueue;
 
     unsigned int nbrOutstanding() const;
-    // 事务完成后，生成响应包并返回
+    // 事务完成后，原请求包作为响应返回
     void accessAndRespond(PacketPtr pkt);
     void sendResponse();
     // 发送响应事件
-    EventFunctionWrapper sendResponseEvent;
+    MemberEventWrapper<&DRAMsim3::sendResponse> sendResponseEvent;
     // 推进控制器一个时钟周期
     void tick();
     // 时钟事件
-    EventFunctionWrapper tickEvent;
+    MemberEventWrapper<&DRAMsim3::tick> tickEvent;
+    DramCalibration *calibration = nullptr;
     // 上游 cache 需要此包直到返回 true，暂存待删除
     std::unique_ptr<DataPacket> pendingDelete;
 
@@ -94,6 +93,11 @@ namespace GNN
 
     void startup();
     void resetStats();
+    // 检查点只在没有在途事务时保存，只剩流控标记
+    void serialize(SectionOut &os) const override;
+    void unserialize(SectionIn &is) override;
+    // 记录事务的接收/完成时刻，用于拟合 AnalyticDram 参数
+    void setCalibration(DramCalibration *c) { calibration = c; }
 
   protected:
     void recvFunctional(PacketPtr pkt);
@@ -15,11 +15,184 @@
  * @Description: 这是默认设置,请设置`customMade`, 打开koroFileHeader查看配置 进行设置: https://github.com/OBKoro1/koro1FileHeader/wiki/%E9%85%8D%E7%BD%AE
  */
 #include "dramsim3_wrapper.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
 namespace GNN
 {
+    namespace
+    {
+        // 按通道配置的临时目录，析构时删除其中登记的文件和目录本身
+        class ChannelConfigDir
+        {
+        public:
+            ChannelConfigDir()
+            {
+                const char*       tmp = std::getenv("TMPDIR");
+                std::string       dir = std::string(tmp && *tmp ? tmp : "/tmp") + "/dramsim3_XXXXXX";
+                std::vector<char> buf(dir.begin(), dir.end());
+                buf.push_back('\0');
+                if (!mkdtemp(buf.data()))
+                    throw std::runtime_error("cannot create directory for DRAMsim3 channel configs: " + dir);
+                path_ = buf.data();
+            }
+            ~ChannelConfigDir()
+            {
+                for (const std::string& f : files_)
+                    std::remove(f.c_str());
+                rmdir(path_.c_str());
+            }
+            ChannelConfigDir(const ChannelConfigDir&)            = delete;
+            ChannelConfigDir& operator=(const ChannelConfigDir&) = delete;
+
+            // 登记目录下的文件并返回其路径，文件由调用者创建
+            std::string add(const std::string& name)
+            {
+                files_.push_back(path_ + "/" + name);
+                return files_.back();
+            }
+
+        private:
+            std::string              path_;
+            std::vector<std::string> files_;
+        };
+    }  // namespace
+
+    void dramsim3_wrapper::createChannelSystems(const std::string& config_file,
+                                                const std::string& output_dir,
+                                                int                threads)
+    {
+        std::ifstream in(config_file);
+        if (!in)
+            throw std::runtime_error("cannot read DRAMsim3 config: " + config_file);
+        addr_map_.reset(new DramAddrMap(config_file));
+        if (addr_map_->numChannels() < num_channels)
+            throw std::runtime_error("DRAMsim3 config has fewer channels than requested: " + config_file);
+
+        // 生成单通道配置：channels 改为 1，各通道的统计输出使用不同前缀
+        std::vector<std::string> lines;
+        std::string              line, prefix = "dramsim3";
+        while (std::getline(in, line))
+        {
+            std::string body = line.substr(0, line.find_first_of(";#"));
+            size_t      eq   = body.find('=');
+            std::string key  = eq == std::string::npos ? "" : body.substr(0, eq);
+            key.erase(0, key.find_first_not_of(" \t"));
+            key.erase(key.find_last_not_of(" \t") + 1);
+            if (key == "channels")
+                line = "channels = 1";
+            else if (key == "output_prefix")
+            {
+                std::istringstream value(body.substr(eq + 1));
+                value >> prefix;
+                continue;
+            }
+            lines.push_back(line);
+        }
+        // 单通道配置只在构造 MemorySystem 时读取，写到本次运行独有的临时目录，离开作用域
+        // （含中途抛出）即删除
+        ChannelConfigDir dir;
+        channel_done_.resize(num_channels);
+        for (int ch = 0; ch < num_channels; ++ch)
+        {
+            std::string   path = dir.add("dramsim3_ch" + std::to_string(ch) + ".ini");
+            std::ofstream out(path);
+            if (!out)
+                throw std::runtime_error("cannot write DRAMsim3 channel config: " + path);
+            for (const std::string& l : lines)
+                out << l << "\n";
+            out << "[other]\noutput_prefix = " << prefix << "_ch" << ch << "\n";
+            out.close();
+            auto& done = channel_done_[ch];
+            channel_systems_.push_back(std::unique_ptr<dramsim3::MemorySystem>(new dramsim3::MemorySystem(
+                path,
+                output_dir,
+                [&done](uint64_t a) { done.emplace_back(a, false); },
+                [&done](uint64_t a) { done.emplace_back(a, true); })));
+        }
+        // 超过主机核数的线程只会互相抢占，每周期一次的同步反而变慢
+        int cores = static_cast<int>(std::thread::hardware_concurrency());
+        if (cores > 0)
+            threads = std::min(threads, cores);
+        pool_.reset(new WorkerPool(std::min(threads, num_channels)));
+        channel_lag_.assign(num_channels, 0);
+    }
+
+    bool dramsim3_wrapper::tickChannels(Tick n)
+    {
+        busy_channels_.clear();
+        for (int ch = 0; ch < num_channels; ++ch)
+        {
+            if (inflight_[ch].empty())
+                channel_lag_[ch] += n;
+            else
+                busy_channels_.push_back(ch);
+        }
+        if (busy_channels_.size() <= 1)
+        {
+            for (int ch : busy_channels_)
+                for (Tick i = 0; i < n; ++i)
+                    channel_systems_[ch]->ClockTick();
+            return false;
+        }
+        pool_->run(static_cast<int>(busy_channels_.size()),
+                   [this, n](int i)
+                   {
+                       dramsim3::MemorySystem* sys = channel_systems_[busy_channels_[i]].get();
+                       for (Tick t = 0; t < n; ++t)
+                           sys->ClockTick();
+                   });
+        return true;
+    }
+
+    void dramsim3_wrapper::catchUpChannel(int ch)
+    {
+        if (channel_lag_[ch] == 0)
+            return;
+        auto start = std::chrono::steady_clock::now();
+        // 落后期间该通道没有事务，补齐的周期不会产生回调
+        for (; channel_lag_[ch] > 0; --channel_lag_[ch])
+            channel_systems_[ch]->ClockTick();
+        assert(channel_done_[ch].empty());
+        host_seconds_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void dramsim3_wrapper::catchUpChannels()
+    {
+        for (int ch = 0; ch < static_cast<int>(channel_systems_.size()); ++ch)
+            catchUpChannel(ch);
+    }
+
+    void dramsim3_wrapper::drainChannels()
+    {
+        // 与共用 MemorySystem 时一致：同一周期内按通道编号顺序回调
+        for (int ch = 0; ch < num_channels; ++ch)
+        {
+            for (const auto& d : channel_done_[ch])
+            {
+                uint64_t addr = addr_map_->insertChannel(d.first, ch);
+                if (d.second)
+                    global_write_callback(addr);
+                else
+                    global_read_callback(addr);
+            }
+            channel_done_[ch].clear();
+        }
+    }
+
     void dramsim3_wrapper::print_stats()
     {
-        memory_system_1->PrintStats();
+        catchUp();
+        catchUpChannels();
+        if (channel_systems_.empty())
+            memory_system_1->PrintStats();
+        for (auto& sys : channel_systems_)
+            sys->PrintStats();
     } // dramsim3 print_stats
     void dramsim3_wrapper::init()
     {
@@ -28,21 +201,60 @@ namespace GNN
     }
     void dramsim3_wrapper::reset_stats()
     {
-        memory_system_1->ResetStats();
+        catchUp();
+        catchUpChannels();
+        if (channel_systems_.empty())
+            memory_system_1->ResetStats();
+        for (auto& sys : channel_systems_)
+            sys->ResetStats();
     } // dramsim3 reset_stats
 
     bool dramsim3_wrapper::can_accept(uint64_t addr, bool is_write)
     {
+        catchUp();
+        int ch = get_channel(addr);
+        if (inflight_[ch].full())
+            return false;
+        if (!channel_systems_.empty())
+            return channel_systems_[ch]->WillAcceptTransaction(addr_map_->removeChannel(addr), is_write);
         return memory_system_1->WillAcceptTransaction(addr, is_write);
     } // dramsim3 willAcceptTransaction
 
-    void dramsim3_wrapper::send_request(uint64_t addr, bool is_write)
+    void dramsim3_wrapper::send_request(PacketPtr pkt)
     {
-
-        bool success = memory_system_1->AddTransaction(addr, is_write);
+        wake();
+        int ch = get_channel(pkt->getAddr());
+        assert(ch < num_channels && "DRAMsim3 channel count exceeds configured channels");
+        int id = inflight_[ch].alloc(pkt);
+        assert(id != TransTable<PacketPtr>::kInvalid);
+        (void)id;
+        ++outstanding_;
+        if (!channel_systems_.empty())
+            catchUpChannel(ch);
+        // 完成回调只调度事件，不会在 tick() 中重入到这里，此时各系统都恰好推进了 dram_cycles_ 个周期
+        if (record_)
+            warm_log_.push_back({dram_cycles_, pkt->getAddr(), pkt->isWrite()});
+        bool success = channel_systems_.empty()
+                         ? memory_system_1->AddTransaction(pkt->getAddr(), pkt->isWrite())
+                         : channel_systems_[ch]->AddTransaction(addr_map_->removeChannel(pkt->getAddr()),
+                                                                pkt->isWrite());
         assert(success);
     } // dramsim3 add read trans
 
+    PacketPtr dramsim3_wrapper::takeInflight(uint64_t addr, bool is_write)
+    {
+        int ch = get_channel(addr);
+        assert(ch < num_channels && "DRAMsim3 channel count exceeds configured channels");
+        TransTable<PacketPtr>& table = inflight_[ch];
+        // 同地址多笔事务按提交先后匹配
+        int id = table.findOldest([addr, is_write](PacketPtr p)
+                                  { return p->getAddr() == addr && p->isWrite() == is_write; });
+        assert(id != TransTable<PacketPtr>::kInvalid);
+        PacketPtr pkt = table[id];
+        table.free(id);
+        return pkt;
+    }
+
     unsigned int dramsim3_wrapper::get_busrt_length() const
     {
         return memory_system_1->GetBurstLength();
@@ -60,14 +272,132 @@ namespace GNN
 
     unsigned int dramsim3_wrapper::get_channel(address_t addr) const
     {
+        if (addr_map_)
+            return addr_map_->decode(addr).channel;
         return memory_system_1->GetChannel(addr);
     }
 
     void dramsim3_wrapper::tick()
     {
-
-        memory_system_1->ClockTick();
+        const bool timing = timed();
+        bool       forked = true;
+        std::chrono::steady_clock::time_point start;
+        if (timing)
+            start = std::chrono::steady_clock::now();
+        if (channel_systems_.empty())
+            memory_system_1->ClockTick();
+        else
+        {
+            forked = tickChannels(1);
+            drainChannels();
+        }
+        if (timing)
+            host_seconds_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        ++dram_cycles_;
+        dram_syncs_ += forked;
+        // 无在途事务时休眠，待下次请求到达时补齐
+        if (outstanding_ == 0 && sleep())
+            return;
         if(!tickEvent.scheduled())
         schedule(tickEvent, curTick() + 1);
     }
+
+    void dramsim3_wrapper::skipCycles(Tick n)
+    {
+        const bool timing = timed();
+        std::chrono::steady_clock::time_point start;
+        if (timing)
+            start = std::chrono::steady_clock::now();
+        if (!channel_systems_.empty())
+        {
+            // 休眠期间没有在途事务，各通道只累计落后周期，不做同步
+            bool forked = tickChannels(n);
+            assert(!forked);
+            (void)forked;
+        }
+        else
+        {
+            for (Tick i = 0; i < n; ++i)
+                memory_system_1->ClockTick();
+        }
+        if (timing)
+            host_seconds_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        dram_cycles_ += n;
+        if (channel_systems_.empty())
+            ++dram_syncs_;
+    }
+
+    void dramsim3_wrapper::printStats(std::ostream& os) const
+    {
+        os << "dramsim3_wrapper: channels=" << num_channels << " threads=" << (pool_ ? pool_->size() : 0)
+           << " cycles=" << dram_cycles_ << " skipped=" << skippedCycles() << " syncs=" << dram_syncs_;
+        if (timed())
+        {
+            os << " host_ms=" << host_seconds_ * 1e3;
+            if (dram_cycles_ > 0)
+                os << " ns_per_cycle=" << host_seconds_ * 1e9 / dram_cycles_;
+        }
+        os << std::endl;
+    }
+
+    void dramsim3_wrapper::serialize(SectionOut& os) const
+    {
+        if (!record_)
+            throw std::runtime_error("dramsim3_wrapper: checkpoint needs setRecord(true) before the run starts");
+        assert(outstanding_ == 0);
+        ClockedObject::serialize(os);
+        os.put(static_cast<int32_t>(num_channels));
+        os.put(!channel_systems_.empty());
+        os.put(dram_cycles_);
+        os.put(dram_syncs_);
+        os.put(channel_lag_);
+        for (const auto& table : inflight_)
+            table.serialize(os);
+        os.put(warm_log_);
+    }
+
+    void dramsim3_wrapper::unserialize(SectionIn& is)
+    {
+        ClockedObject::unserialize(is);
+        if (is.get<int32_t>() != num_channels || is.get<bool>() != !channel_systems_.empty())
+            throw std::runtime_error("dramsim3_wrapper: checkpoint channel configuration mismatch");
+        is.get(dram_cycles_);
+        is.get(dram_syncs_);
+        is.get(channel_lag_);
+        for (auto& table : inflight_)
+            table.unserialize(is);
+        is.get(warm_log_);
+        warmUp();
+    }
+
+    void dramsim3_wrapper::warmUp()
+    {
+        warming_ = true;
+        const bool            per_channel = !channel_systems_.empty();
+        std::vector<uint64_t> clock(per_channel ? channel_systems_.size() : 1, 0);
+        auto                  advance = [&](size_t s, uint64_t to)
+        {
+            dramsim3::MemorySystem* sys = per_channel ? channel_systems_[s].get() : memory_system_1;
+            for (; clock[s] < to; ++clock[s])
+                sys->ClockTick();
+            if (per_channel)
+                channel_done_[s].clear();
+        };
+        for (const WarmRecord& rec : warm_log_)
+        {
+            if (!per_channel)
+            {
+                advance(0, rec.cycle);
+                memory_system_1->AddTransaction(rec.addr, rec.is_write != 0);
+                continue;
+            }
+            int ch = get_channel(rec.addr);
+            advance(ch, rec.cycle);
+            channel_systems_[ch]->AddTransaction(addr_map_->removeChannel(rec.addr), rec.is_write != 0);
+        }
+        // 落后的通道保持落后，之后照常补齐
+        for (size_t s = 0; s < clock.size(); ++s)
+            advance(s, dram_cycles_ - (per_channel ? channel_lag_[s] : 0));
+        warming_ = false;
+    }
 }
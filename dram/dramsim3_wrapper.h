@@ -3,23 +3,30 @@
 #include "buffer/buffer.h"
 #include <functional>
 #include <iostream>
+#include <memory>
 #include <stdexcept>
 #include <unordered_map>
 #include <vector>
 
+#include "common/clocked.h"
 #include "common/common.h"
 #include "common/debug.h"
 #include "common/define.h"
 #include "common/object.h"
 #include "common/packet.h"
+#include "common/trans_table.h"
+#include "dram/addr_map.h"
 #include "dram/sim_dram_storage.h"
 #include "event/eventq.h"
+#include "event/worker_pool.h"
 #include "memory_system.h"
 #define QUEUE_SIZE 64
+// 单通道在途事务上限，远大于 DRAMsim3 事务队列深度，表满时 can_accept 返回 false
+static constexpr size_t kMaxInflightPerChannel = 128;
 namespace GNN
 {
   class Buffer;  // 前向声明
-  class dramsim3_wrapper : public SimObject
+  class dramsim3_wrapper : public ClockedObject
   {
   private:
     unsigned int depth;
@@ -27,21 +34,70 @@ namespace GNN
     unsigned int bandwidth;
     double       frequency;
 
-    std::ofstream trace_out_file_;
+    // 通道数运行时指定，需与 DRAMsim3 配置的通道数一致
+    int num_channels;
 
-    bool vld4repeate_ch[CHANNEL_NUM][64];
-    bool channle_vld[CHANNEL_NUM] = { false };
+    std::vector<std::vector<bool>> vld4repeate_ch;  // [ch][64]
+    std::vector<bool>              channle_vld;
 
-    bool is_ch_rd_send[CHANNEL_NUM] = { false };
-    bool is_ch_wr_send[CHANNEL_NUM] = { false };
+    std::vector<bool> is_ch_rd_send;
+    std::vector<bool> is_ch_wr_send;
 
     // 事件驱动集成：记录每个请求地址等待的Buffer
     std::unordered_map<uint64_t, Buffer*> waitingAddrToBuf;
 
+    // 已提交但尚未回调的事务数，为0时 DRAMsim3 空闲，wrapper 可休眠
+    uint64_t outstanding_ = 0;
+    // 每通道在途请求包。DRAMsim3 回调只带地址，按地址找到最早提交的同地址
+    // 同方向事务号，再把原请求包交回，完成路径不再新建包
+    std::vector<TransTable<PacketPtr>> inflight_;  // [ch]
+    PacketPtr takeInflight(uint64_t addr, bool is_write);
+
     // 多通道回调
     std::vector<std::function<void(PacketPtr)>> read_callbacks;
     std::vector<std::function<void(PacketPtr)>> write_callbacks;
 
+    // 按通道拆分：每通道一个单通道配置的 MemorySystem，地址去掉通道位后送入，
+    // 由线程池逐周期并行推进。各通道的完成先缓存在本通道队列，周期结束后
+    // 在主线程按通道编号顺序回调，结果与线程数无关。为空时共用 memory_system_1
+    std::vector<std::unique_ptr<dramsim3::MemorySystem>> channel_systems_;  // [ch]
+    std::vector<std::vector<std::pair<uint64_t, bool>>> channel_done_;     // [ch] (去通道位地址, is_write)
+    std::unique_ptr<DramAddrMap>                        addr_map_;
+    std::unique_ptr<WorkerPool>                         pool_;
+    // 没有在途事务的通道不参与逐周期推进，只累计落后的周期数，下次提交事务或输出统计前
+    // 在主线程一次补齐；只剩一个通道有事务时也不经线程池同步
+    std::vector<Tick> channel_lag_;  // [ch]
+    std::vector<int>  busy_channels_;
+    void createChannelSystems(const std::string& config_file, const std::string& output_dir, int threads);
+    // 推进 n 个周期，返回是否经线程池同步
+    bool tickChannels(Tick n);
+    void catchUpChannel(int ch);
+    void catchUpChannels();
+    void drainChannels();
+
+    // 主机侧开销：推进 DRAM 时钟（含完成回调与通道间同步）的墙钟时间，
+    // 用于比较共用 MemorySystem 与按通道并行推进的实际收益。
+    // 每周期两次取时钟不便宜，只在按通道模式或 setProfile(true) 时计时
+    uint64_t dram_cycles_  = 0;  // 推进的 DRAM 周期数，含休眠补齐
+    uint64_t dram_syncs_   = 0;  // 推进调用次数，按通道模式下为线程池 fork/join 次数
+    double   host_seconds_ = 0;
+    bool     profile_      = false;
+    bool     timed() const { return profile_ || pool_; }
+
+    // 检查点：DRAMsim3 不导出内部状态（队列、行缓冲、刷新计时、统计），改为记录每笔
+    // 事务提交时的 DRAM 周期，恢复时在新建的 MemorySystem 上按原周期重放到保存时的
+    // 周期，重放期间的完成回调丢弃。只在没有在途事务时保存
+    struct WarmRecord
+    {
+        uint64_t cycle;
+        uint64_t addr;
+        uint64_t is_write;
+    };
+    bool                    record_  = false;
+    bool                    warming_ = false;
+    std::vector<WarmRecord> warm_log_;
+    void                    warmUp();
+
     // // 模拟DRAM存储：独立类，提供4GB、burst=64支持
     // SimDramStorage sim_storage;
 
@@ -54,50 +110,61 @@ namespace GNN
     // bool writePacket(PacketPtr pkt) { return sim_storage.writePacket(pkt); }
     // bool readPacket(PacketPtr pkt) { return sim_storage.readPacket(pkt); }
 
+    // threads 为 0 时所有通道共用一个 MemorySystem（逐周期串行推进全部通道）；
+    // 大于 0 时每通道一个 MemorySystem，由 threads 个线程并行推进，配置无法读取时抛出 std::runtime_error
     dramsim3_wrapper(const std::string& config_file,
                      const std::string& output_dir,
-                     const std::string& trace_out_file)
-      : SimObject("dramsim3_wrapper"), tickEvent([this] { tick(); }, name())
+                     int                channels = CHANNEL_NUM,
+                     int                threads  = 0)
+      : ClockedObject("dramsim3_wrapper"), num_channels(channels),
+        vld4repeate_ch(channels, std::vector<bool>(64, false)), channle_vld(channels, false),
+        is_ch_rd_send(channels, false), is_ch_wr_send(channels, false),
+        inflight_(channels, TransTable<PacketPtr>(kMaxInflightPerChannel)),
+        tickEvent(*this, "tickEvent")
     {
-      memory_system_1 = (new dramsim3::MemorySystem(
-        config_file,
-        output_dir,
-        std::bind(&dramsim3_wrapper::global_read_callback, this, std::placeholders::_1),
-        std::bind(&dramsim3_wrapper::global_write_callback, this, std::placeholders::_1)));
+      setTickEvent(tickEvent);
+      if (threads > 0)
+      {
+        createChannelSystems(config_file, output_dir, threads);
+        memory_system_1 = channel_systems_[0].get();
+      }
+      else
+        memory_system_1 = (new dramsim3::MemorySystem(
+          config_file,
+          output_dir,
+          std::bind(&dramsim3_wrapper::global_read_callback, this, std::placeholders::_1),
+          std::bind(&dramsim3_wrapper::global_write_callback, this, std::placeholders::_1)));
       burst_length    = memory_system_1->GetBurstLength();
       bandwidth       = memory_system_1->GetQueueSize();
       frequency       = 1 / (memory_system_1->GetTCK());
       std::cout << "burst_length:" << burst_length << " bandwidth:" << bandwidth
                 << " frequency:" << frequency << std::endl;
-      for (int i = 0; i < CHANNEL_NUM; i++)
-      {
-        for (int j = 0; j < 64; j++)
-        {
-          vld4repeate_ch[i][j] = false;
-        }
-      }
-      read_callbacks.resize(CHANNEL_NUM);
-      write_callbacks.resize(CHANNEL_NUM);
+      read_callbacks.resize(channels);
+      write_callbacks.resize(channels);
     }
     void global_read_callback(uint64_t addr)
     {
-      // 创建读包，wrapper 负责释放
-      PacketPtr pkt = PacketManager::create_read_packet(addr, BURST_BITS / STORAGE_SIZE);
-
-      int ch = this->get_channel(addr);
+      if (warming_)
+        return;
+      assert(outstanding_ > 0);
+      --outstanding_;
+      // 交回原请求包，保留 bank_id/buffer_idx/cmd_id/事务号等元信息
+      PacketPtr pkt = takeInflight(addr, false);
+      int       ch  = this->get_channel(addr);
       if (read_callbacks[ch])
       {
         read_callbacks[ch](pkt);
       }
-      // 所有权转移到接收回调（DRAMsim3::readComplete），由其在响应发送后释放
+      // 所有权转移到接收回调（DRAMsim3::readComplete），作为响应继续向上游传递
     }
     void global_write_callback(uint64_t addr)
     {
-      // 创建写包，示例中填充16个word，wrapper 负责释放
-      std::vector<storage_t> dummy(64, 0);
-      PacketPtr              pkt = PacketManager::create_write_packet(addr, dummy);
-
-      int ch = this->get_channel(addr);
+      if (warming_)
+        return;
+      assert(outstanding_ > 0);
+      --outstanding_;
+      PacketPtr pkt = takeInflight(addr, true);
+      int       ch  = this->get_channel(addr);
       if (write_callbacks[ch])
       {
         write_callbacks[ch](pkt);
@@ -106,15 +173,22 @@ namespace GNN
     }
     ~dramsim3_wrapper() { }
 
+    // 共用 MemorySystem 时也统计推进 DRAM 时钟的墙钟时间
+    void setProfile(bool on) { profile_ = on; }
+    // 记录事务提交日志，供检查点恢复时重放；要保存检查点的运行须在仿真开始前打开
+    void setRecord(bool on) { record_ = on; }
+    void serialize(SectionOut& os) const override;
+    void unserialize(SectionIn& is) override;
+
     // 注册回调
     void set_read_callback(int channel, std::function<void(PacketPtr)> cb)
     {
-      if (channel >= 0 && channel < CHANNEL_NUM)
+      if (channel >= 0 && channel < num_channels)
         read_callbacks[channel] = cb;
     }
     void set_write_callback(int channel, std::function<void(PacketPtr)> cb)
     {
-      if (channel >= 0 && channel < CHANNEL_NUM)
+      if (channel >= 0 && channel < num_channels)
         write_callbacks[channel] = cb;
     }
 
@@ -148,7 +222,7 @@ namespace GNN
       else
       {
         bool is_send = false;
-        for (int i = 0; i < 128; i++)
+        for (size_t i = 0; i < vld4repeate_ch[ch].size(); i++)
         {
           if (!vld4repeate_ch[ch][i])
           {
@@ -164,12 +238,13 @@ namespace GNN
       }
     }
 
-    EventFunctionWrapper tickEvent;
-
     void print_stats();
     void reset_stats();
+    // 打印 DRAM 时钟推进的周期数、同步次数与主机耗时
+    void printStats(std::ostream& os) const;
     bool can_accept(uint64_t addr, bool is_write);
-    void send_request(uint64_t addr, bool is_write);  // 已被替换
+    // 提交请求包，完成时由对应通道的回调交回同一个包
+    void send_request(PacketPtr pkt);
 
     unsigned int get_busrt_length() const;
     unsigned int get_bandwidth() const;
@@ -179,6 +254,11 @@ namespace GNN
     unsigned int validate_dram_reads(address_t* read_address);
 
     void tick();
+    MemberEventWrapper<&dramsim3_wrapper::tick> tickEvent;
+
+  protected:
+    // 休眠期间 DRAMsim3 仍需逐周期推进（刷新等），唤醒时一次补齐
+    void skipCycles(Tick n) override;
   };
 }  // namespace GNN
 #endif  // DRAMSIM3_WRAPPER_H
@@ -12,10 +12,13 @@
 #include "common/define.h"
 #include "common/file_read.h"
 #include "common/packet.h"
+#include "common/serialize.h"
+#include <algorithm>
 #include <bitset>
 #include <cstdint>
 #include <cstring>
 #include <map>
+#include <stdexcept>
 #include <string>
 #include <vector>
 namespace GNN
@@ -34,6 +37,7 @@ namespace GNN
 
     uint64_t              base_addr;       // 起始地址（字节）
     uint64_t              capacity_bytes;  // 容量（字节）
+    int                   channels;        // 交织通道数：每 channels * CHANNEL_ADDR_DIF 字节为一个交织块
     std::vector<uint16_t> storage;         // 存储单元，按16bit元素存放
 
     inline bool inRange(addr_t addr, storage_t bytes) const
@@ -49,9 +53,10 @@ namespace GNN
   public:
     SimDramStorage(uint64_t           base             = 0,
                    const std::string& base_path        = "./data/",
-                   const std::string& data_file_suffix = ".txt")
+                   const std::string& data_file_suffix = ".txt",
+                   int                channel_num      = CHANNEL_NUM)
       : FileReader(TOTAL_SLICE_NUM_CFG, TOTAL_INST_NUM_CFG), base_addr(base),
-        capacity_bytes(kCapacityBytes)
+        capacity_bytes(kCapacityBytes), channels(channel_num)
     {
       setDataFilePathTemplate(base_path, data_file_suffix);
       // 为模拟DRAM分配存储空间（以16位元素为单位）
@@ -60,6 +65,7 @@ namespace GNN
       D_INFO("SIM_DRAM_STORAGE", "Total words: %lld", total_words);
     }
     uint64_t total_words_num = 0;
+    uint64_t written_end     = 0;  // 写入过的最高位置（字），检查点镜像须覆盖到这里
     void     readDataFile()
     {
       readDataResult result;
@@ -120,6 +126,36 @@ namespace GNN
 
       return total_data_points / (BURST_BITS / STORAGE_SIZE);  // 返回总数据点数除以32，即总burst数
     }
+
+    // 检查点：镜像只保存已装载和写入过的前缀，其余部分恢复后仍为 0。
+    // 恢复时代替 readLayer0AllFoldersData 的文本解析
+    void serialize(CheckpointOut& cp) const
+    {
+      uint64_t image_words = std::max(total_words_num, written_end);
+      cp.param("storage.total_words_num", total_words_num);
+      cp.param("storage.written_end", written_end);
+      cp.param("storage.addr_max", storage_addr_max);
+      cp.param("storage.number", storage_number);
+      cp.section("storage.image", storage.data(), image_words * sizeof(uint16_t));
+    }
+
+    void unserialize(CheckpointIn& cp)
+    {
+      cp.param("storage.total_words_num", total_words_num);
+      cp.param("storage.written_end", written_end);
+      cp.param("storage.addr_max", storage_addr_max);
+      cp.param("storage.number", storage_number);
+      size_t      bytes = 0;
+      const void* image = cp.section("storage.image", bytes);
+      if (bytes != std::max(total_words_num, written_end) * sizeof(uint16_t) ||
+          bytes > storage.size() * sizeof(uint16_t))
+        throw std::runtime_error("checkpoint storage image size mismatch");
+      std::memcpy(storage.data(), image, bytes);
+      D_INFO("SIM_DRAM_STORAGE", "Restored %lld words from checkpoint", bytes / sizeof(uint16_t));
+    }
+
+    // 已装载数据对应的 burst 数，与 readLayer0AllFoldersData 的返回值一致
+    uint64_t burstNum() const { return storage_number / (BURST_BITS / STORAGE_SIZE); }
     // 读取指定文件夹中的所有txt文件
     std::vector<std::vector<storage_t>> readFolderData(const std::string& folder_path) const
     {
@@ -178,6 +214,7 @@ namespace GNN
       {
         storage[idx + i] = data[i];
       }
+      written_end = std::max<uint64_t>(written_end, idx + data.size());
       return true;
     }
 
@@ -191,28 +228,32 @@ namespace GNN
       storage_t bytes = words * sizeof(storage_t);
       if (!inRange(addr, bytes))
         return false;
-      std::vector<uint16_t> out(words);
+      // 直接写入包内数据（一个 burst 以内无需堆分配）
+      PacketSpan out = pkt->mutableData(words);
+      // 各通道的数据按 16bit 字在交织块内轮流排布，块大小与字步长均随通道数变化
+      const uint64_t block = static_cast<uint64_t>(channels) * CHANNEL_ADDR_DIF;
+      const uint64_t step  = static_cast<uint64_t>(channels);
       if (BITMAP_WORD_BITS <= 16 && FLOAT_CAL)  //float16 or int16
       {                                         //BITMAP_WORD_BITS<=16
-        uint64_t idx = (addr % 512) / 64;
-        if (addr >= 512)
+        uint64_t idx = (addr % block) / 64;
+        if (addr >= block)
         {
-          idx += (addr - addr % 512) / 2;
+          idx += (addr - addr % block) / 2;
         }
         // std::cout<<"read addr:"<<addr<<"  index:"<<idx<<std::endl;
         for (storage_t i = 0; i < words; ++i)
         {
-          out[i] = storage[idx + i * 8];
+          out[i] = storage[idx + i * step];
           // std::cout << "  addr:" << (idx + i * 16)
           //   << "  data(bin):" << std::bitset<16>(static_cast<uint16_t>(out[i])) << std::endl;
         }
       }
       else if (BITMAP_WORD_BITS > 16 && FLOAT_CAL)  //fixed_point_data
       {
-        uint64_t idx = (addr % 512) / 32;
-        if (addr >= 512)
+        uint64_t idx = (addr % block) / 32;
+        if (addr >= block)
         {
-          idx += (addr - addr % 512) / 2;
+          idx += (addr - addr % block) / 2;
         }
 
         uint16_t num = 0;
@@ -221,7 +262,7 @@ namespace GNN
         {
           for (storage_t j = 0; j < 2; ++j)
           {
-            out[num] = storage[idx + i * 16 + j * 8];
+            out[num] = storage[idx + i * 2 * step + j * step];
             num++;
             // std::cout << "  addr:" << (idx + i * 16+j)
             //     << "  data(bin):" << std::bitset<16>(static_cast<uint16_t>(out[i])) << std::endl;
@@ -230,10 +271,10 @@ namespace GNN
       }
       else if (BITMAP_WORD_BITS <= 32 && !FLOAT_CAL)  //fixed_point_data
       {
-        uint64_t idx = (addr % 512) / 32;
-        if (addr >= 512)
+        uint64_t idx = (addr % block) / 32;
+        if (addr >= block)
         {
-          idx += (addr - addr % 512) / 2;
+          idx += (addr - addr % block) / 2;
         }
 
         uint16_t num = 0;
@@ -242,7 +283,7 @@ namespace GNN
         {
           for (storage_t j = 0; j < 2; ++j)
           {
-            out[num] = storage[idx + i * 16 + j * 8];
+            out[num] = storage[idx + i * 2 * step + j * step];
             num++;
             // std::cout << "  addr:" << (idx + i * 16+j)
             //     << "  data(bin):" << std::bitset<16>(static_cast<uint16_t>(out[i])) << std::endl;
@@ -252,10 +293,10 @@ namespace GNN
       else if (BITMAP_WORD_BITS > 32 && !FLOAT_CAL)  //fixed_point_data0
       {
 
-        uint64_t idx = (addr % 512) / 16;
-        if (addr >= 512)
+        uint64_t idx = (addr % block) / 16;
+        if (addr >= block)
         {
-          idx += (addr - addr % 512) / 2;
+          idx += (addr - addr % block) / 2;
         }
 
         uint16_t num = 0;
@@ -264,7 +305,7 @@ namespace GNN
         {
           for (storage_t j = 0; j < 4; ++j)
           {
-            out[num] = storage[idx + i * 32 + j * 8];
+            out[num] = storage[idx + i * 4 * step + j * step];
             num++;
             // std::cout << "  addr:" << (idx + i * 32 + j)
             //           << "  data(bin):" << std::bitset<16>(static_cast<uint16_t>(out[i]))
@@ -343,7 +384,6 @@ namespace GNN
           out[i] = static_cast<uint16_t>(v32 & 0xFFFFu);  // low16
         }
       }
-      pkt->setData(out);
       return true;
     }
 
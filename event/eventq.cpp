@@ -16,9 +16,17 @@ Event *Event::insertBefore(Event *event, Event *curr) {
   if (!curr || *event < *curr) {
     event->nextBin = curr;
     event->nextInBin = NULL;
-  } else {
+  } else if (event->_seq > curr->_seq) {
     event->nextBin = curr->nextBin;
     event->nextInBin = curr;
+  } else {
+    // 恢复调度的事件序号较旧, 落在 bin 内按序号递减的位置
+    Event *prev = curr;
+    while (prev->nextInBin && prev->nextInBin->_seq > event->_seq)
+      prev = prev->nextInBin;
+    event->nextInBin = prev->nextInBin;
+    prev->nextInBin = event;
+    return curr;
   }
   // 防止 event->nextBin == event
   assert(event != event->nextBin);
@@ -44,35 +52,30 @@ Event *Event::removeItem(Event *event, Event *top) {
   return top;
 }
 
-void EventQueue::insert(Event *event) {
-  event->_scheduled = true;
-  if (!head || *event <= *head) {
-    head = Event::insertBefore(event, head);
+void EventQueue::insertSorted(Event *&top, Event *event) {
+  if (!top || *event <= *top) {
+    top = Event::insertBefore(event, top);
     return;
   }
 
-  Event *prev = head;
-  Event *curr = head->nextBin;
+  Event *prev = top;
+  Event *curr = top->nextBin;
   while (curr && *curr < *event) {
     prev = curr;
     curr = curr->nextBin;
   }
-  assert(Event::insertBefore(event, curr));
   prev->nextBin = Event::insertBefore(event, curr);
-
-   
 }
 
-void EventQueue::remove(Event *event) {
-  event->_scheduled = false;
-  if (head == NULL)
+void EventQueue::removeSorted(Event *&top, Event *event) {
+  if (top == NULL)
     throw std::runtime_error("event not found!");
-  if (*head == *event) {
-    head = Event::removeItem(event, head);
+  if (*top == *event) {
+    top = Event::removeItem(event, top);
     return;
   }
-  Event *prev = head;
-  Event *curr = head->nextBin;
+  Event *prev = top;
+  Event *curr = top->nextBin;
   while (curr && *curr < *event) {
     prev = curr;
     curr = curr->nextBin;
@@ -82,15 +85,207 @@ void EventQueue::remove(Event *event) {
   prev->nextBin = Event::removeItem(event, curr);
 }
 
+void EventQueue::insert(Event *event) {
+  event->_seq = ++insertSeq;
+  link(event);
+}
+
+void EventQueue::link(Event *event) {
+  event->_scheduled = true;
+  if (backend == QueueBackend::LINKED_LIST)
+    insertSorted(head, event);
+  else
+    wheelInsert(event);
+}
+
+void EventQueue::remove(Event *event) {
+  event->_scheduled = false;
+  if (backend == QueueBackend::LINKED_LIST)
+    removeSorted(head, event);
+  else
+    wheelRemove(event);
+}
+
+void EventQueue::markSlot(size_t slot, bool occupied) {
+  uint64_t bit = 1ULL << (slot & 63);
+  if (occupied)
+    wheelOccupied[slot >> 6] |= bit;
+  else
+    wheelOccupied[slot >> 6] &= ~bit;
+}
+
+void EventQueue::wheelInsert(Event *event) {
+  Tick when = event->when();
+  assert(when >= wheelBase);
+  if (when - wheelBase < wheelSize) {
+    size_t slot = wheelSlot(when);
+    insertSorted(wheel[slot], event);
+    markSlot(slot, true);
+    ++wheelCount;
+    return;
+  }
+  // 超出时间轮窗口, 放入溢出集合
+  event->_far = true;
+  farEvents.emplace(when, event->priority(), event->_seq, event);
+}
+
+void EventQueue::wheelRemove(Event *event) {
+  if (event->_far) {
+    size_t n = farEvents.erase(
+        FarKey(event->when(), event->priority(), event->_seq, event));
+    event->_far = false;
+    if (!n)
+      throw std::runtime_error("event not found!");
+    return;
+  }
+  size_t slot = wheelSlot(event->when());
+  removeSorted(wheel[slot], event);
+  --wheelCount;
+  if (!wheel[slot])
+    markSlot(slot, false);
+}
+
+// 推进时间轮起点, 并把落入新窗口的溢出事件迁入时间轮.
+void EventQueue::wheelAdvance(Tick when) {
+  assert(when >= wheelBase);
+  wheelBase = when;
+  while (!farEvents.empty() &&
+         std::get<0>(*farEvents.begin()) - wheelBase < wheelSize) {
+    Event *event = std::get<3>(*farEvents.begin());
+    farEvents.erase(farEvents.begin());
+    event->_far = false;
+    size_t slot = wheelSlot(event->when());
+    insertSorted(wheel[slot], event);
+    markSlot(slot, true);
+    ++wheelCount;
+  }
+}
+
+Event *EventQueue::wheelHead() const {
+  if (wheelCount == 0) {
+    if (farEvents.empty())
+      return NULL;
+    // 同 bin 中最后插入的事件最先出队
+    auto it = farEvents.begin();
+    auto next = std::next(it);
+    while (next != farEvents.end() && std::get<0>(*next) == std::get<0>(*it) &&
+           std::get<1>(*next) == std::get<1>(*it)) {
+      it = next;
+      ++next;
+    }
+    return std::get<3>(*it);
+  }
+  // 从 wheelBase 对应的槽开始环形查找第一个非空槽
+  size_t start = wheelSlot(wheelBase);
+  size_t words = wheelOccupied.size();
+  size_t w = start >> 6;
+  uint64_t bits = wheelOccupied[w] & (~0ULL << (start & 63));
+  for (size_t i = 0; i <= words; ++i) {
+    if (bits)
+      return wheel[(w << 6) + __builtin_ctzll(bits)];
+    w = (w + 1) % words;
+    bits = wheelOccupied[w];
+  }
+  return NULL;
+}
+
+void EventQueue::park(Event *event, Tick when) {
+  assert(!event->scheduled());
+  assert(when >= getCurTick());
+  event->setWhen(when);
+  event->_seq = ++insertSeq;
+  parked.push_back(event);
+}
+
+Tick EventQueue::unpark(Event *event) {
+  auto it = std::find(parked.begin(), parked.end(), event);
+  assert(it != parked.end());
+  parked.erase(it);
+  link(event);
+  return event->when();
+}
+
+void EventQueue::parkAt(Event *event, Tick when, uint64_t seq) {
+  assert(!event->scheduled());
+  assert(when >= getCurTick() && seq <= insertSeq);
+  event->setWhen(when);
+  event->_seq = seq;
+  parked.push_back(event);
+}
+
+void EventQueue::restart(Tick when, uint64_t seq) {
+  while (!empty())
+    deschedule(getHead());
+  parked.clear();
+  _curTick = when;
+  wheelBase = when;
+  insertSeq = seq;
+}
+
+// 逐周期调度下排在 next 之前的 tick 依次空转, 每次把自己排到下一周期并取得新序号.
+// next 是队列中最早的真实事件, 它之前只有空转的 tick: 同一 when 的一组空转 tick
+// 每周期按出队先后取得递增的新序号, 而同 bin 内序号大者先出队, 所以组内次序每
+// 周期反转一次. 按周期数的奇偶即可直接跳到下一个有别的事件 (next 或更晚的空转
+// tick) 的周期, 代价与休眠周期数无关
+void EventQueue::advanceParked(const Event *next) {
+  std::vector<Event *> group;
+  for (;;) {
+    Event *first = parked.front();
+    for (Event *e : parked)
+      if (before(e, first))
+        first = e;
+    if (!before(first, next))
+      return;
+    Tick limit = next->when();
+    for (Event *e : parked)
+      if (e->when() > first->when())
+        limit = std::min(limit, e->when());
+    if (first->when() == limit) {
+      // 与 next 同周期且排在它前面, 只空转这一次
+      first->setWhen(first->when() + 1);
+      first->_seq = ++insertSeq;
+      continue;
+    }
+    group.clear();
+    for (Event *e : parked)
+      if (e->when() == first->when())
+        group.push_back(e);
+    // 最后一次空转 (limit - 1 周期) 的出队次序决定新序号
+    std::sort(group.begin(), group.end(), before);
+    if ((limit - first->when() - 1) & 1)
+      std::reverse(group.begin(), group.end());
+    for (Event *e : group) {
+      e->setWhen(limit);
+      e->_seq = ++insertSeq;
+    }
+  }
+}
+
 Event *EventQueue::serviceOne() {
-  Event *event = head;
-  Event *next = head->nextInBin;
+  if (!parked.empty())
+    advanceParked(getHead());
+  Event **top = &head;
+  if (backend == QueueBackend::TIMING_WHEEL) {
+    if (wheelCount == 0)
+      wheelAdvance(std::get<0>(*farEvents.begin()));
+    Event *first = wheelHead();
+    if (first->when() != wheelBase)
+      wheelAdvance(first->when());
+    top = &wheel[wheelSlot(first->when())];
+  }
+  Event *event = *top;
+  Event *next = event->nextInBin;
   event->_scheduled = false;
   if (next) {
-    next->nextBin = head->nextBin;
-    head = next;
+    next->nextBin = event->nextBin;
+    *top = next;
   } else {
-    head = head->nextBin;
+    *top = event->nextBin;
+  }
+  if (backend == QueueBackend::TIMING_WHEEL) {
+    --wheelCount;
+    if (!*top)
+      markSlot(wheelSlot(event->when()), false);
   }
   setCurTick(event->when());
   // D_DEBUG("EVENTQ","%s,process event time :%d",event->name(), event->when());
@@ -101,6 +296,7 @@ Event *EventQueue::serviceOne() {
 }
 
 Event *EventQueue::replaceHead(Event *s) {
+  assert(backend == QueueBackend::LINKED_LIST);
   Event *t = head;
   head = s;
   return t;
@@ -108,7 +304,17 @@ Event *EventQueue::replaceHead(Event *s) {
 
 const char *Event::description() const { return "generic"; }
 
-EventQueue::EventQueue(const std::string &n)
-    : objName(n), head(NULL), _curTick(0) {}
+EventQueue::EventQueue(const std::string &n, QueueBackend backend,
+                       Tick wheel_size)
+    : objName(n), head(NULL), _curTick(0), backend(backend), wheelSize(64),
+      wheelBase(0), wheelCount(0), insertSeq(0) {
+  while (wheelSize < wheel_size)
+    wheelSize <<= 1;
+  wheelMask = wheelSize - 1;
+  if (backend == QueueBackend::TIMING_WHEEL) {
+    wheel.assign(wheelSize, NULL);
+    wheelOccupied.assign(wheelSize / 64, 0);
+  }
+}
 
 } // namespace GNN
@@ -9,7 +9,11 @@
 #include <iosfwd>
 #include <list>
 #include <memory>
+#include <set>
 #include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
 #include "common/debug.h"
 namespace GNN {
 class EventQueue;
@@ -46,6 +50,10 @@ protected:
   Tick _when;
   Priority _priority;
   bool _scheduled = false;
+  // 插入序号, 同 (when, priority) 中序号大者先出队
+  uint64_t _seq = 0;
+  // 是否在时间轮溢出集合中
+  bool _far = false;
   void setWhen(Tick when) { _when = when; }
   bool initialized() const { return true; }
 
@@ -60,6 +68,7 @@ public:
   Tick when() const { return _when; }
   Priority priority() const { return _priority; }
   bool scheduled() const { return _scheduled; }
+  uint64_t seq() const { return _seq; }
   void release() {
     if (!scheduled())
       delete this;
@@ -89,19 +98,61 @@ inline bool operator!=(const Event &l, const Event &r) {
   return l.when() != r.when() || l.priority() != r.priority();
 }
 
+// 事件队列后端:
+//  LINKED_LIST  : 原有的按 (when, priority) 排序的二维链表, 插入为线性遍历
+//  TIMING_WHEEL : 日历队列/时间轮, [wheelBase, wheelBase + wheelSize) 内的事件
+//                 按 tick 直接落槽 (O(1)), 更远的事件进入溢出集合, 时间轮推进时迁入.
+// 两种后端的出队顺序完全一致 (同 when 同 priority 时后插入者先出队).
+enum class QueueBackend { LINKED_LIST, TIMING_WHEEL };
+
 class EventQueue {
 private:
   std::string objName;
   Event *head;
   Tick _curTick;
+  QueueBackend backend;
+
+  // 时间轮: 每个槽是一个只包含单一 tick 的 bin 链表 (按 priority 排序)
+  std::vector<Event *> wheel;
+  std::vector<uint64_t> wheelOccupied; // 槽非空位图, 用于快速查找下一个事件
+  Tick wheelSize;
+  Tick wheelMask;
+  Tick wheelBase;
+  size_t wheelCount;
+  // 溢出集合: (when, priority, seq), 迁入时间轮时按 seq 落入 bin 内原位
+  typedef std::tuple<Tick, Event::Priority, uint64_t, Event *> FarKey;
+  std::set<FarKey> farEvents;
+  uint64_t insertSeq;
+
+  // 休眠对象的 tick 事件: 不在队列中, 只记录逐周期调度时本应所处的
+  // (when, priority, seq), 每当真实事件出队前按序空转推进, 唤醒时原位入队
+  std::vector<Event *> parked;
+  static bool before(const Event *l, const Event *r) {
+    return *l < *r || (*l == *r && l->_seq > r->_seq);
+  }
+  void advanceParked(const Event *next);
+
+  static void insertSorted(Event *&top, Event *event);
+  static void removeSorted(Event *&top, Event *event);
   void insert(Event *event);
+  void link(Event *event);
   void remove(Event *event);
+  void wheelInsert(Event *event);
+  void wheelRemove(Event *event);
+  void wheelAdvance(Tick when);
+  Event *wheelHead() const;
+  size_t wheelSlot(Tick when) const { return when & wheelMask; }
+  void markSlot(size_t slot, bool occupied);
   EventQueue(const EventQueue &);
 
 public:
-  EventQueue(const std::string &n);
+  // wheel_size 仅对 TIMING_WHEEL 生效, 会向上取整为 2 的幂
+  EventQueue(const std::string &n,
+             QueueBackend backend = QueueBackend::LINKED_LIST,
+             Tick wheel_size = 1024);
   virtual const std::string name() const { return objName; }
   void name(const std::string &st) { objName = st; }
+  QueueBackend queueBackend() const { return backend; }
   void schedule(Event *event, Tick when) {
     if (event->scheduled())
   //  std::cout<<"schedule event: " << event->name() << " " << event->scheduled() << std::endl;
@@ -112,15 +163,28 @@ public:
 
   }
   void deschedule(Event *event) { remove(event); }
+  // 以空转方式代替逐周期调度 event, 首次空转在 when
+  void park(Event *event, Tick when);
+  // 按空转推进到的位置恢复调度, 返回恢复后的 when
+  Tick unpark(Event *event);
+  // 检查点恢复: 按保存的 (when, seq) 原样登记空转事件
+  void parkAt(Event *event, Tick when, uint64_t seq);
+  // 检查点恢复: 撤销已调度与空转的全部事件, 时刻与插入序号回到保存时的值
+  void restart(Tick when, uint64_t seq);
+  uint64_t seqCounter() const { return insertSeq; }
   void reschedule(Event *event, Tick when) {
     assert(when >= getCurTick());
+    if (event->scheduled())
+      remove(event);
     event->setWhen(when);
     insert(event);
   }
-  Tick nextTick() const { return head->when(); }
+  Tick nextTick() const { return getHead()->when(); }
   void setCurTick(Tick newVal) { _curTick = newVal; }
   Tick getCurTick() const { return _curTick; }
-  Event *getHead() const { return head; }
+  Event *getHead() const {
+    return backend == QueueBackend::LINKED_LIST ? head : wheelHead();
+  }
   Event *serviceOne();
   void serviceEvents(Tick when) {
     while (!empty()) {
@@ -130,7 +194,11 @@ public:
     }
     setCurTick(when);
   }
-  bool empty() const { return head == NULL; }
+  bool empty() const {
+    if (backend == QueueBackend::LINKED_LIST)
+      return head == NULL;
+    return wheelCount == 0 && farEvents.empty();
+  }
 
   Event *replaceHead(Event *s);
   virtual ~EventQueue() {
@@ -168,39 +236,47 @@ public:
   void setCurTick(Tick newVal) { eventq->setCurTick(newVal); }
 };
 
-// template <auto F>
-// class MemberEventWrapper final: public Event, public Named
-// {
-//     using CLASS = MemberFunctionClass_t<F>;
-//     static_assert(std::is_same_v<void, MemberFunctionReturn_t<F>>);
-//     static_assert(std::is_same_v<MemberFunctionArgsTuple_t<F>,
-//     std::tuple<>>);
-// public:
-//     [[deprecated("Use reference version of this constructor instead")]]
-//     MemberEventWrapper(CLASS *object,
-//                        bool del = false,
-//                        Priority p = Default_Pri):
-//         MemberEventWrapper{*object, del, p}
-//     {}
-//     MemberEventWrapper(CLASS &object,
-//                        bool del = false,
-//                        Priority p = Default_Pri):
-//         Event(p),
-//         Named(object.name() + ".wrapped_event"),
-//         mObject(&object)
-//     {
-//     }
-//     void process() override {
-//         (mObject->*F)();
-//     }
-//     const char *description() const override { return "EventWrapped"; }
-// private:
-//     CLASS *mObject;
-// };
-
-// template <class T, void (T::* F)()>
-// using EventWrapper [[deprecated("Use MemberEventWrapper instead")]]
-//     = MemberEventWrapper<F>;
+// 成员函数指针萃取：取出所属类、返回值与参数列表
+template <typename F> struct MemberFunctionTraits;
+template <class C, class R, class... Args>
+struct MemberFunctionTraits<R (C::*)(Args...)> {
+  using Class = C;
+  using Return = R;
+  using ArgsTuple = std::tuple<Args...>;
+};
+template <auto F>
+using MemberFunctionClass_t = typename MemberFunctionTraits<decltype(F)>::Class;
+template <auto F>
+using MemberFunctionReturn_t =
+    typename MemberFunctionTraits<decltype(F)>::Return;
+template <auto F>
+using MemberFunctionArgsTuple_t =
+    typename MemberFunctionTraits<decltype(F)>::ArgsTuple;
+
+// 直接回调成员函数的事件：编译期绑定 F，无 std::function 类型擦除与堆分配；
+// 名字只保存静态字符串指针，仅在调用 name() 时与所属对象名拼接
+template <auto F>
+class MemberEventWrapper final : public Event
+{
+  using CLASS = MemberFunctionClass_t<F>;
+  static_assert(std::is_same_v<void, MemberFunctionReturn_t<F>>);
+  static_assert(std::is_same_v<MemberFunctionArgsTuple_t<F>, std::tuple<>>);
+
+public:
+  MemberEventWrapper(CLASS &object, const char *name,
+                     Priority p = Default_Pri)
+      : Event(p), mObject(&object), _name(name) {}
+
+  void process() override { (mObject->*F)(); }
+  const std::string name() const override {
+    return mObject->name() + "." + _name;
+  }
+  const char *description() const override { return "MemberEventWrapped"; }
+
+private:
+  CLASS *mObject;
+  const char *_name;
+};
 
 class EventFunctionWrapper : public Event {
 private:
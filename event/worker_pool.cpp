@@ -0,0 +1,78 @@
+#include "event/worker_pool.h"
+#include <cassert>
+#include <chrono>
+
+namespace GNN {
+
+// 自旋等待的时长上限，覆盖逐周期调用的间隔；超过后认为进入空闲期。
+// 按时间而非次数计：yield 在核数不足时会让出整个时间片，次数换算不出时长
+static constexpr std::chrono::microseconds kSpinTime{50};
+
+WorkerPool::WorkerPool(int threads) {
+  for (int id = 1; id < threads; ++id)
+    workers.emplace_back(&WorkerPool::workerLoop, this, id);
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lk(mtx);
+    stop.store(true, std::memory_order_release);
+    generation.fetch_add(1, std::memory_order_release);
+  }
+  cv.notify_all();
+  for (auto &t : workers)
+    t.join();
+}
+
+void WorkerPool::runShare(int id) {
+  for (int i = id; i < job_n; i += size())
+    (*job)(i);
+}
+
+void WorkerPool::run(int n, const std::function<void(int)> &fn) {
+  if (workers.empty() || n <= 1) {
+    for (int i = 0; i < n; ++i)
+      fn(i);
+    return;
+  }
+  assert(remaining.load(std::memory_order_relaxed) == 0);
+  job = &fn;
+  job_n = n;
+  remaining.store(static_cast<int>(workers.size()), std::memory_order_relaxed);
+  {
+    // 持锁递增，避免与正要进入休眠的工作线程错过通知
+    std::lock_guard<std::mutex> lk(mtx);
+    generation.fetch_add(1, std::memory_order_release);
+  }
+  cv.notify_all();
+  runShare(0);
+  while (remaining.load(std::memory_order_acquire) != 0)
+    std::this_thread::yield();
+  job = nullptr;
+}
+
+void WorkerPool::workerLoop(int id) {
+  uint64_t seen = 0;
+  while (true) {
+    uint64_t gen = generation.load(std::memory_order_acquire);
+    const auto spin_end = std::chrono::steady_clock::now() + kSpinTime;
+    while (gen == seen && std::chrono::steady_clock::now() < spin_end) {
+      std::this_thread::yield();
+      gen = generation.load(std::memory_order_acquire);
+    }
+    if (gen == seen) {
+      std::unique_lock<std::mutex> lk(mtx);
+      cv.wait(lk, [&] {
+        return generation.load(std::memory_order_acquire) != seen;
+      });
+      gen = generation.load(std::memory_order_acquire);
+    }
+    seen = gen;
+    if (stop.load(std::memory_order_acquire))
+      return;
+    runShare(id);
+    remaining.fetch_sub(1, std::memory_order_acq_rel);
+  }
+}
+
+} // namespace GNN
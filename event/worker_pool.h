@@ -0,0 +1,47 @@
+#ifndef __EVENT_WORKER_POOL_H__
+#define __EVENT_WORKER_POOL_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace GNN {
+
+// 常驻线程池，用于逐周期的细粒度并行（如各 DRAM 通道的时钟推进）：
+// - run(n, fn) 对 i in [0, n) 执行 fn(i)，调用线程也参与，全部完成后返回
+// - 任务按 i % size() 静态分给固定线程，同一任务总在同一线程上执行
+// - 每次 run 之间工作线程先自旋等待，长时间无任务后转入条件变量休眠，
+//   仿真空闲期不占满 CPU
+// fn 之间不得共享可写状态；结果的合并由调用方在 run 返回后按任务编号完成
+class WorkerPool {
+public:
+  // threads 为含调用线程在内的线程数，<= 1 时 run 在调用线程上顺序执行
+  explicit WorkerPool(int threads);
+  ~WorkerPool();
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  int size() const { return static_cast<int>(workers.size()) + 1; }
+  void run(int n, const std::function<void(int)> &fn);
+
+private:
+  void workerLoop(int id);
+  void runShare(int id);
+
+  std::vector<std::thread> workers;
+  const std::function<void(int)> *job = nullptr;
+  int job_n = 0;
+  std::atomic<uint64_t> generation{0};
+  std::atomic<int> remaining{0};
+  std::atomic<bool> stop{false};
+  std::mutex mtx;
+  std::condition_variable cv;
+};
+
+} // namespace GNN
+
+#endif // __EVENT_WORKER_POOL_H__
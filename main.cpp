@@ -1,9 +1,13 @@
 #include "buffer/buffer.h"
+#include "common/clocked.h"
 #include "common/debug.h"
 #include "common/define.h"
 #include "common/object.h"
+#include "common/serialize.h"
 #include "compute/ComputeModule.h"
+#include "dram/analytic_dram.h"
 #include "dram/dram_arb.h"
+#include "dram/dram_trace.h"
 #include "dram/dramsim3.h"
 #include "dram/dramsim3_wrapper.h"
 #include "dram/sim_dram_storage.h"
@@ -12,9 +16,15 @@
 #include "spare/DecoderModule.h"
 #include "spare/FeatureBank.h"
 #include "spare/WeightBank.h"
+#include <cassert>
 #include <cstdint>
+#include <cstdlib>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
 
 using namespace GNN;
 
@@ -33,6 +43,15 @@ static void forEachObject(void (SimObject::*mem_func)())
     (obj->*mem_func)();
   }
 }
+// 设置所有时钟对象空闲时是否休眠
+static void setIdleSkip(bool enable)
+{
+  for (auto* obj : SimObject::simObjectList)
+  {
+    if (auto* clocked = dynamic_cast<ClockedObject*>(obj))
+      clocked->setIdleSkip(enable);
+  }
+}
 namespace GNN
 {
   uint64_t storage_addr_max = 0;
@@ -40,60 +59,315 @@ namespace GNN
   uint64_t dram_burst_num   = 0;
 
 }  // namespace GNN
-int main()
+int main(int argc, char* argv[])
 {
+  // 通道(bank)数：默认 CHANNEL_NUM，可由第一个命令行参数指定，需与 DRAMsim3 配置的通道数一致
+  const int num_banks = argc > 1 ? std::atoi(argv[1]) : CHANNEL_NUM;
+  if (num_banks <= 0)
+  {
+    std::cerr << "invalid channel count: " << argv[1] << std::endl;
+    return 1;
+  }
+  // 第二个参数选择运行模式：
+  //   timing（默认）；functional：存储侧功能访问即时应答，只保留解码/配对时序，用于快速预筛负载；
+  //   replay [trace]：只用 DRAMsim3 回放 DramArb 记录的请求轨迹（见 dram_trace_capture）；
+  //   checkpoint <tick|pN> [file]：timing 运行到第 tick 周期（或解码器切换到第 N 个参数）时解码器
+  //     暂停发请求，DMA/仲裁器/DRAM 排空后保存检查点再继续；restore [file]：从检查点继续，跳过数据解析。
+  //     暂停排空会推迟之后的全部时序，结果与保存检查点的那次运行一致，与不暂停的运行不同
+  const std::string sim_mode = argc > 2 ? argv[2] : "timing";
+  const bool        do_checkpoint = sim_mode == "checkpoint";
+  const bool        do_restore    = sim_mode == "restore";
+  if (sim_mode == "functional")
+    SimObject::setMemoryMode(SimObject::MemoryMode::Functional);
+  else if (sim_mode != "timing" && sim_mode != "replay" && !do_checkpoint && !do_restore)
+  {
+    std::cerr << "invalid mode: " << sim_mode << " (timing|functional|replay|checkpoint|restore)"
+              << std::endl;
+    return 1;
+  }
+  Tick   hold_tick  = 0;
+  size_t hold_param = SIZE_MAX;
+  if (do_checkpoint)
+  {
+    const char* arg   = argc > 3 ? argv[3] : "";
+    char*       end   = nullptr;
+    const bool  param = arg[0] == 'p';
+    uint64_t    value = std::strtoull(arg + param, &end, 10);
+    if (end == arg + param || *end != '\0' || (param ? value >= LLAMA_7B_PARAMS.size() : value == 0))
+    {
+      std::cerr << "checkpoint needs a tick > 0 or p<param index below " << LLAMA_7B_PARAMS.size() << ">"
+                << std::endl;
+      return 1;
+    }
+    (param ? hold_param : hold_tick) = value;
+  }
+
   // 配置常量
-  constexpr int num_banks = 8;
 
   constexpr int         num_upstreams  = 4;
+  // DramArb 上游改用信用流控（默认拒绝/重试）。信用按上游静态平分 bank 输入缓冲，每个上游可用的缓冲少于
+  // 共享时，默认负载（8 通道）上比拒绝/重试慢约 12%（最后一个 burst 在 76133 周期，重试为 67709），因此默认关闭
+  constexpr bool        credit_flow    = false;
+  // DramArb 仲裁策略：fifo（持续服务编号最小的非空FIFO）| frfcfs（与上次发出的请求同行者优先）| drr（加权公平）
+  const std::string     arb_policy     = "fifo";
+  constexpr unsigned    frfcfs_age_cap = 16;     // 队首最多被越过的次数
+  // drr 的每上游权重与带宽上限（bitmap, weight, feature, 写buffer），上限为每窗口请求数，0 不限
+  const std::vector<unsigned> drr_weights = { 1, 2, 4, 1 };
+  const std::vector<unsigned> drr_caps    = { 0, 0, 0, 0 };
+  constexpr Tick        drr_cap_window = 1000;
+  // DRAM 后端：dramsim3（周期精确）| analytic（按校准参数的排队模型）。
+  // analytic 尚未在真实 DRAMsim3 上拟合验证，也没有测出相对 dramsim3 的加速，仅作实验选项
+  const std::string     dram_backend   = "dramsim3";
+  // DRAMsim3 推进线程数：0 为所有通道共用一个 MemorySystem；>0 为每通道一个 MemorySystem 并行推进（线程数不超过主机核数）。
+  // 按通道模式尚无多核实测加速，默认关闭
+  constexpr int         dram_threads   = 0;
+  constexpr bool        dram_profile   = false;  // 共用 MemorySystem 时也统计推进 DRAM 时钟的主机耗时（按通道模式总是统计）
+  constexpr bool        dram_calibrate = false;  // dramsim3 后端下记录事务并拟合 analytic 参数
+  // 地址交织：linear（逻辑地址直接送 DRAM）| xor（行号异或到 bank）| perm（按 addr_perm 重排行号位）
+  const std::string     addr_interleave = "linear";
+  const std::vector<int> addr_perm      = {};
+  constexpr bool        dram_trace_capture = false;  // 记录 DramArb 发往 DRAM 的事务，供 replay 模式回放
+  constexpr unsigned    write_high     = 0;      // 写排空高水位，0 表示写严格优先
+  constexpr unsigned    write_low      = 0;      // 写排空低水位
   constexpr uint64_t    max_cycles     = 30000000;
+  // 时钟对象空闲时休眠、唤醒时补齐跳过的周期；关闭后逐周期 tick（与改动前一样跑满 max_cycles），
+  // 用于校验两者结果一致
+  constexpr bool        idle_skip      = true;
   constexpr int         bitmap_size    = BITMAP_SIZE;
   constexpr int         wt_bank_size   = WT_SIZE;
   constexpr int         fw_bank_size   = FW_SIZE;
+  // 各 DMA bank 的缓冲深度（每 bank 缓冲个数，2 即乒乓），加深可让 DMA 提前取数以掩盖 DRAM 延迟抖动
+  constexpr int         bitmap_buf_depth  = 2;
+  constexpr int         weight_buf_depth  = 2;
+  constexpr int         feature_buf_depth = 2;
+  // 位图库 DMA 流检测：统计各 bank 的命令是否为顺序流，认定后在命令衔接处同一周期接上已排队的下一条。
+  // 默认负载上深度 2 时没有排队命令可接，深度 4 时每 bank 只接上 3 次、总周期不变，默认关闭
+  constexpr bool        stream_detect      = false;
+  // DMA 每 bank 每周期最多发出的读请求数。每通道两周期一个 burst 的 DRAM 上请求被反压（issue 统计
+  // blocked 过半），加宽无效；DRAM 每周期能收一个 burst 时，宽度 1 的权重库 full 达 97%，宽度 2 使
+  // 默认负载由 45451 周期降到 43679，与把 arb_buffer_size 加到 512 的效果相同（两者叠加为 43675）
+  constexpr int         dma_issue_width    = 1;
+  constexpr int         arb_buffer_size    = 128;  // DramArb 每 bank 输入缓冲容量
+  // 权重在 DRAM 中的布局：0 为各切片预先连续打包；非 0 时按原矩阵行主序存放，值为矩阵一行占的
+  // bank 行数（4096 列 16 位、8 通道时为 FILE_TOTAL_COL_CFG * WORD_SIZE / BURST_BITS / 8 = 16），
+  // 每条权重命令是切片行数 × 1 行、行距为一个矩阵行的 2D 描述符。取 1 时与打包布局地址相同、结果一致；
+  // 取 16 时默认负载 67753 周期（打包为 67709），行主序存放基本不损失带宽
+  constexpr int         weight_row_pitch   = 0;
   // 文件路径
   constexpr const char* config_file    = "./DRAMsim3-master/configs/HBM2_4Gb_x128.ini";
   constexpr const char* output_dir     = ".";
-  constexpr const char* trace_out_file = "./output/trace_out_file.txt";
+  constexpr const char* dram_trace_file = "./output/dram_trace.bin";
+  constexpr const char* dram_model_file = "./output/dram_model.cfg";
+  constexpr const char* checkpoint_file = "./output/checkpoint.ckpt";
 
   constexpr const char* layer0_path = "./data/floating_point_data_test/llama75";
 
+  const int         ckpt_arg  = do_checkpoint ? 4 : 3;
+  const std::string ckpt_path = argc > ckpt_arg ? argv[ckpt_arg] : checkpoint_file;
+  // 检查点不保存端口信用与校准/轨迹记录，DRAM 只支持可重放的 dramsim3；不休眠时 tick 一直在
+  // 队列中，没有排空的边界
+  if ((do_checkpoint || do_restore) &&
+      (dram_backend != "dramsim3" || credit_flow || dram_calibrate || dram_trace_capture || !idle_skip))
+  {
+    std::cerr << "checkpoint/restore needs the dramsim3 backend with idle_skip on and credit_flow, "
+                 "dram_calibrate, dram_trace_capture off"
+              << std::endl;
+    return 1;
+  }
+  // 恢复时配置须与保存时一致
+  std::ostringstream ckpt_config;
+  ckpt_config << num_banks << ' ' << arb_policy << ' ' << dram_threads << ' ' << addr_interleave << ' '
+              << write_high << ' ' << write_low << ' ' << bitmap_buf_depth << ' ' << weight_buf_depth
+              << ' ' << feature_buf_depth << ' ' << stream_detect << ' ' << dma_issue_width << ' '
+              << arb_buffer_size << ' ' << weight_row_pitch << ' ' << config_file << ' ' << layer0_path;
+
   // 初始化仿真系统
-  gSim                         = new EventQueue("main_queue");
+  gSim                         = new EventQueue("main_queue", QueueBackend::TIMING_WHEEL);
   miniDebugLevel               = GNN::DBG_DEBUG;  // SIM_DRAM_STORAGE FILE_READ
   // miniDebugModules = {"SPARSE", "DECODER", "", "",
   //                     "WeightBank", "FeatureBank", "BitmapBank",
   //                     "DmaBuffer","DMA","DRAM_ARB"};
   //    miniDebugModules = {"CAM", "", "DECODER", "BUG", "FILE_READ", "SIM_DRAM_STORAGE", "","CAM"};
   miniDebugModules             = { "", "RESULT", "SIM_DRAM_STORAGE", "" };
-  // 创建存储和数据接口
-  SimDramStorage* sim_storages = new SimDramStorage(0, "*", ".txt");
 
-  // 读取layer_0文件夹下所有子文件夹的数据
-  uint64_t layer0_burst_num = sim_storages->readLayer0AllFoldersData(layer0_path);
+  // 轨迹回放：不读数据、不建 DMA/解码器/仲裁器，请求流直接驱动 DRAMsim3
+  if (sim_mode == "replay")
+  {
+    const std::string trace_path = argc > 3 ? argv[3] : dram_trace_file;
+    // replay 只持有 wrapper 的裸指针，wrapper 须先于 replay 声明以后于其析构
+    std::unique_ptr<dramsim3_wrapper> wrapper;
+    std::unique_ptr<DramTraceReplay>  replay;
+    try
+    {
+      wrapper.reset(new dramsim3_wrapper(config_file, output_dir, num_banks, dram_threads));
+      wrapper->setProfile(dram_profile);
+      replay.reset(new DramTraceReplay("dram_replay", trace_path, wrapper.get()));
+    }
+    catch (const std::runtime_error& e)
+    {
+      std::cerr << e.what() << std::endl;
+      return 1;
+    }
+    if (replay->channels() != num_banks)
+    {
+      std::cerr << "trace has " << replay->channels() << " channels, running with " << num_banks
+                << std::endl;
+      return 1;
+    }
+    setIdleSkip(idle_skip);
+    forEachObject(&SimObject::init);
+    std::cout << "\n---- Replay Start ----" << std::endl;
+    while (!gSim->empty() && gSim->getCurTick() < max_cycles)
+    {
+      gSim->serviceOne();
+    }
+    std::cout << "---- Replay End ---- tick=" << gSim->getCurTick() << std::endl;
+    replay->report(std::cout);
+    delete gSim;
+    return 0;
+  }
+
+  // 创建存储和数据接口（存储按 num_banks 个通道交织读取）
+  SimDramStorage* sim_storages = new SimDramStorage(0, "*", ".txt", num_banks);
+
+  // 读取layer_0文件夹下所有子文件夹的数据；恢复时直接取检查点中的存储镜像
+  uint64_t                      layer0_burst_num = 0;
+  std::unique_ptr<CheckpointIn> ckpt_in;
+  if (do_restore)
+  {
+    try
+    {
+      ckpt_in.reset(new CheckpointIn(ckpt_path));
+      std::string saved_config;
+      ckpt_in->param("main.config", saved_config);
+      if (saved_config != ckpt_config.str())
+      {
+        std::cerr << ckpt_path << " was saved with another configuration: " << saved_config << std::endl;
+        return 1;
+      }
+      sim_storages->unserialize(*ckpt_in);
+    }
+    catch (const std::runtime_error& e)
+    {
+      std::cerr << e.what() << std::endl;
+      return 1;
+    }
+    layer0_burst_num = sim_storages->burstNum();
+  }
+  else
+    layer0_burst_num = sim_storages->readLayer0AllFoldersData(layer0_path);
 
   // 也可以继续使用原来的方法读取单个文件（如果需要）
   // sim_storages->readDataFile();
 
   // 创建DRAM控制器和仲裁器
-  auto*   wrapper = new dramsim3_wrapper(config_file, output_dir, trace_out_file);
-  DramArb dramArb("dram_arb", 128, num_upstreams);
+  DramArb     dramArb("dram_arb", arb_buffer_size, num_upstreams, num_banks);
+  std::unique_ptr<DramAddrMap>    addr_map_ptr;
+  std::unique_ptr<AddrInterleave> interleave;
+  try
+  {
+    addr_map_ptr.reset(new DramAddrMap(config_file));
+    interleave.reset(new AddrInterleave(
+      *addr_map_ptr, num_banks, AddrInterleave::parsePolicy(addr_interleave), addr_perm));
+  }
+  catch (const std::runtime_error& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  const DramAddrMap& addr_map = *addr_map_ptr;
+  dramArb.setAddrInterleave(interleave.get());
+  dramArb.setStorage(sim_storages);
+  std::unique_ptr<DramTraceWriter> dram_trace;
+  if (dram_trace_capture)
+  {
+    try
+    {
+      dram_trace.reset(new DramTraceWriter(dram_trace_file, num_banks));
+      dramArb.setTrace(dram_trace.get());
+    }
+    catch (const std::runtime_error& e)
+    {
+      std::cerr << "warning: " << e.what() << std::endl;
+    }
+  }
 
   // 创建Bank模块
-  BitmapBank  bitmap_bank("bmap_", 0, bitmap_size, num_banks, layer0_burst_num / bitmap_size / 8);
+  BitmapBank  bitmap_bank("bmap_", 0, bitmap_size, num_banks, layer0_burst_num / bitmap_size / num_banks);
   WeightBank  weight_bank("w_", 0x1000000, wt_bank_size, num_banks);
   FeatureBank feature_bank("f_", 0x15000000, fw_bank_size, num_banks);
+  bitmap_bank.setBufferDepth(bitmap_buf_depth);
+  weight_bank.setBufferDepth(weight_buf_depth);
+  weight_bank.setRowMajorLayout(weight_row_pitch);
+  feature_bank.setBufferDepth(feature_buf_depth);
+  bitmap_bank.setStreamDetect(stream_detect);
+  bitmap_bank.setIssueWidth(dma_issue_width);
+  weight_bank.setIssueWidth(dma_issue_width);
+  feature_bank.setIssueWidth(dma_issue_width);
 
   // 创建解码、计算与写 Buffer 模块
   Buffer        decoder_buffer("decoder_buf", num_banks, BITMAP_LINE_SIZE * FW_ROW_SIZE);
-  DecoderModule decoder("decoder_", num_banks, sim_storages, &decoder_buffer);
+  DecoderModule decoder("decoder_", num_banks, &decoder_buffer);
+  if (hold_param != SIZE_MAX)
+    decoder.holdAtParam(hold_param);
   ComputeModule compute("compute0", num_banks);
 
   // 创建DRAM实例
-  std::vector<DRAMsim3*> drams;
+  std::vector<SimObject*>          drams;
+  std::unique_ptr<DramCalibration> dram_calibration;
+  DramModelParams                  dram_params;
   drams.reserve(num_banks);
-  for (int bank = 0; bank < num_banks; ++bank)
+  dramsim3_wrapper* wrapper = nullptr;
+  if (dram_backend == "dramsim3")
   {
-    drams.push_back(new DRAMsim3("dramsim3_" + std::to_string(bank), bank, wrapper));
+    try
+    {
+      wrapper = new dramsim3_wrapper(config_file, output_dir, num_banks, dram_threads);
+      wrapper->setProfile(dram_profile);
+      wrapper->setRecord(do_checkpoint);
+    }
+    catch (const std::runtime_error& e)
+    {
+      std::cerr << e.what() << std::endl;
+      return 1;
+    }
+    // DMA bank 与 DRAM 通道一一绑定，DRAMsim3 解出的通道必须与之一致，否则请求会落到别的通道
+    // （按通道模式下会送进另一个通道的 MemorySystem），直接拒绝运行
+    int mismatches = interleave->verify([wrapper](uint64_t a) { return int(wrapper->get_channel(a)); });
+    if (mismatches > 0)
+    {
+      std::cerr << "address interleave " << interleave->name() << ": " << mismatches
+                << " sampled lines map to another DRAMsim3 channel, check address_mapping in "
+                << config_file << std::endl;
+      return 1;
+    }
+    if (dram_calibrate)
+      dram_calibration.reset(new DramCalibration(addr_map, num_banks));
+    for (int bank = 0; bank < num_banks; ++bank)
+    {
+      auto* dram = new DRAMsim3("dramsim3_" + std::to_string(bank), bank, wrapper);
+      dram->setCalibration(dram_calibration.get());
+      drams.push_back(dram);
+    }
+  }
+  else if (dram_backend == "analytic")
+  {
+    try
+    {
+      dram_params = DramModelParams::load(dram_model_file);
+    }
+    catch (const std::runtime_error& e)
+    {
+      std::cerr << e.what() << " (run the dramsim3 backend with dram_calibrate first)" << std::endl;
+      return 1;
+    }
+    for (int bank = 0; bank < num_banks; ++bank)
+      drams.push_back(new AnalyticDram("analytic_dram_" + std::to_string(bank), bank, dram_params, addr_map));
+  }
+  else
+  {
+    std::cerr << "invalid dram backend: " << dram_backend << " (dramsim3|analytic)" << std::endl;
+    return 1;
   }
 
   // 连接所有端口
@@ -124,17 +398,121 @@ int main()
     // DMA仲裁器到DRAM
     bindPorts(dramArb.getPort("request" + b), drams[bank]->getPort("mem_side"));
   }
+  if (credit_flow)
+    dramArb.enableCreditFlow();
+  dramArb.setWriteWatermarks(write_high, write_low);
+  if (arb_policy == "frfcfs")
+    dramArb.setArbPolicy(std::unique_ptr<ArbPolicy>(
+      new FrFcfsPolicy(addr_map, num_banks, num_upstreams, frfcfs_age_cap)));
+  else if (arb_policy == "drr")
+    dramArb.setArbPolicy(
+      std::unique_ptr<ArbPolicy>(new DrrPolicy(num_banks, drr_weights, drr_caps, drr_cap_window)));
+  else if (arb_policy != "fifo")
+  {
+    std::cerr << "invalid arb policy: " << arb_policy << " (fifo|frfcfs|drr)" << std::endl;
+    return 1;
+  }
 
   // 初始化所有对象
+  setIdleSkip(idle_skip);
   forEachObject(&SimObject::init);
 
   // 运行仿真
   std::cout << "\n---- Simulation Start ----" << std::endl;
-  while (!gSim->empty() && gSim->getCurTick() < max_cycles)
+  if (ckpt_in)
+  {
+    try
+    {
+      SimObject::unserializeAll(*ckpt_in);
+    }
+    catch (const std::runtime_error& e)
+    {
+      std::cerr << e.what() << std::endl;
+      return 1;
+    }
+    ckpt_in.reset();
+    std::cout << "---- Restored param " << decoder.paramIndex() << " at tick " << gSim->getCurTick()
+              << " ----" << std::endl;
+    decoder.resume();
+  }
+  if (hold_tick > 0)
   {
-    gSim->serviceOne();
+    while (!gSim->empty() && gSim->getCurTick() < hold_tick)
+    {
+      gSim->serviceOne();
+    }
+    decoder.hold();
   }
+  bool checkpointed = false;
+  for (;;)
+  {
+    while (!gSim->empty() && gSim->getCurTick() < max_cycles)
+    {
+      gSim->serviceOne();
+    }
+    // 解码器停在检查点参数上、其余模块已排空（只剩休眠对象的空转 tick）：保存后继续
+    if (!decoder.held() || !gSim->empty())
+      break;
+    try
+    {
+      CheckpointOut cp(ckpt_path);
+      cp.param("main.config", ckpt_config.str());
+      sim_storages->serialize(cp);
+      SimObject::serializeAll(cp);
+      cp.close();
+    }
+    catch (const std::runtime_error& e)
+    {
+      std::cerr << e.what() << std::endl;
+      return 1;
+    }
+    checkpointed = true;
+    std::cout << "---- Checkpoint param " << decoder.paramIndex() << " at tick " << gSim->getCurTick()
+              << " ----" << std::endl;
+    decoder.resume();
+  }
+  if (do_checkpoint && !checkpointed)
+  {
+    std::cerr << "checkpoint point " << argv[3] << " was not reached, no checkpoint written" << std::endl;
+    return 1;
+  }
+  const bool drained = gSim->empty();
   std::cout << "---- Simulation End ----" << std::endl;
+  if (dramArb.arbPolicy())
+    dramArb.arbPolicy()->report(std::cout);
+  dramArb.printStats(std::cout);
+  bitmap_bank.printStats(std::cout);
+  weight_bank.printStats(std::cout);
+  feature_bank.printStats(std::cout);
+  if (wrapper)
+    wrapper->printStats(std::cout);
+  if (dram_trace)
+  {
+    dram_trace->close();
+    std::cout << "DramTrace: " << dram_trace_file << " records=" << dram_trace->records()
+              << " bytes=" << dram_trace->bytes() << std::endl;
+  }
+  if (dram_calibration)
+  {
+    DramModelParams fitted = dram_calibration->fit();
+    try
+    {
+      fitted.save(dram_model_file);
+    }
+    catch (const std::runtime_error& e)
+    {
+      D_WARN("DRAM", "%s", e.what());
+    }
+    dram_calibration->report(fitted, std::cout);
+  }
+  // 缓冲中预取而未被消费的数据等由各对象归还；排空结束时其余包都应已在完成路径上释放
+  forEachObject(&SimObject::releasePackets);
+  PacketPool& pool = PacketPool::local();
+  std::cout << "PacketPool: allocs=" << pool.allocs() << " capacity=" << pool.capacity()
+            << " high_water=" << pool.highWater() << " outstanding=" << pool.outstanding()
+            << std::endl;
+  assert(!drained || pool.outstanding() == 0);
+  (void)drained;
 
   delete gSim;
   return 0;
@@ -26,8 +26,10 @@ namespace GNN
 
   void BitmapBank::init()
   {
-    startNextDmaCommand();
-    startNextDmaCommand();
+    DmaBuffer::init();
+    // 每个buf预先排入一条命令
+    for (int i = 0; i < bufferDepth(); ++i)
+      startNextDmaCommand();
   }
 
   void BitmapBank::startNextDmaCommand()
@@ -36,13 +38,13 @@ namespace GNN
     {
       if (cmd_id_cnts_[i] >= inst_burst_num_)
         continue;
-      if (inst_cnts_[i] >= 2)
+      if (inst_cnts_[i] >= bufferDepth())
       {
-        D_WARN("BitmapBank", "Bank%d instruction counter full (inst_cnt=2)", i);
+        D_WARN("BitmapBank", "Bank%d instruction counter full (inst_cnt=%d)", i, inst_cnts_[i]);
         continue;
       }
       addr_t addr =
-        base_addr_ + cmd_id_cnts_[i] * INST_ADDR_STRIDE * burst_num_;
+        base_addr_ + cmd_id_cnts_[i] * addr_stride_ * burst_num_;
       startBitmapLoadCommand(cmd_id_cnts_[i]++, addr, burst_num_, i);
     }
   }
@@ -73,7 +75,7 @@ namespace GNN
     {
 
       addr_t addr =
-        base_addr_ + cmd_id_cnts_[bank_id] * INST_ADDR_STRIDE * burst_num_;
+        base_addr_ + cmd_id_cnts_[bank_id] * addr_stride_ * burst_num_;
       D_INFO("BitmapBank",
              "Bank %d: Complete cmd %lu, addr=%d, lines=%d,inst_burst_num_=%d",
              bank_id,
@@ -95,27 +97,28 @@ namespace GNN
       int idx = getReadableBufferIndex(bank);
       if (idx < 0)
         continue;
-      assert(!bank_controllers_[bank].buffers[idx].dma_pkt.empty());
-      auto&     dq  = bank_controllers_[bank].buffers[idx].dma_pkt;
+      auto& buf = bank_controllers_[bank].buffers[idx];
+      assert(!buf.drained());
       // if(bank==2)
       // D_INFO("CAM", "dq.size() %d bank %d idx %d next_read_idx_:%d",dq.size(),bank,idx,next_read_idx_[bank]);
-      PacketPtr pkt = dq.front();
+      // 游标前移即交出所有权：发送失败时由响应队列持有，重试成功后整块释放
+      PacketPtr pkt = buf.front();
+      buf.read_pos++;
       assert(pkt != nullptr);
       pkt->setCmdId(buf_cmd_id_[bank][idx]);
       pkt->setBankId(bank);
       pkt->setBufferIdx(idx);
 
-      PacketPtr req_pkt = req_pkt_[bank];
       if (computePorts[bank].sendTimingResp(pkt))
       {
         recv_req_send_resp[bank] = false;
-        dq.erase(dq.begin());
-        if (dq.empty())
+        // 应答的是缓冲中的数据包，下游的请求包就此用完
+        PacketManager::free_packet(req_pkt_[bank]);
+        req_pkt_[bank] = nullptr;
+        if (buf.drained())
         {
           D_INFO("BitmapBank", "Buffer empty, release bank=%d", bank);
           releaseBankBuffer(bank, idx);
-          PacketManager::free_packet(req_pkt);
-          req_pkt_[bank] = nullptr;
         }
       }
       else
@@ -132,4 +135,16 @@ namespace GNN
     return DmaBuffer::getPort(if_name, idx);
   }
 
+  void BitmapBank::serialize(SectionOut& os) const
+  {
+    DmaBuffer::serialize(os);
+    os.put(cmd_id_cnts_);
+  }
+
+  void BitmapBank::unserialize(SectionIn& is)
+  {
+    DmaBuffer::unserialize(is);
+    is.get(cmd_id_cnts_);
+  }
+
 }  // namespace GNN
@@ -19,6 +19,8 @@ public:
     void CompleteCommand(uint64_t bank_id) override;
     void sendRespond() override;
     Port &getPort(const std::string &if_name, int idx = -1) override;
+    void serialize(SectionOut &os) const override;
+    void unserialize(SectionIn &is) override;
 
 private:
     void startNextDmaCommand();
@@ -2,16 +2,19 @@
 
 #include "DecoderModule.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <fstream>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
 #include "common/common.h"
 #include "common/debug.h"
 #include "common/packet.h"
+#include "common/serialize.h"
 
 namespace GNN
 {
@@ -74,30 +77,24 @@ namespace GNN
     // 统一调用 DecoderModule 的响应处理函数
     return owner.recvTimingResp(pkt, bank_id, bank_name);
   }
-  uint64_t bm_total_cycle[8];
-  uint64_t fw_total_cycle[8];
-  uint64_t wt_total_cycle[8];
-  uint64_t bm_current_cycle[8];
-  uint64_t fw_current_cycle[8];
-  uint64_t wt_current_cycle[8];
-  void     DecoderModule::BankRequestPort::recvReqRetry()
+  void DecoderModule::BankRequestPort::recvReqRetry()
   {
     // 对端可再次接收请求，标记该 bank 需要重试
     D_DEBUG("DECODER", "Bank %d : Retry request,bank_name: %s", bank_id, bank_name.c_str());
     if (bank_name == "bmap")
     {
       owner.pending_request_[bank_id]  = true;
-      bm_total_cycle[bank_id]         += gSim->getCurTick() - bm_current_cycle[bank_id];
+      owner.bm_total_cycle[bank_id]   += gSim->getCurTick() - owner.bm_current_cycle[bank_id];
     }
     if (bank_name == "weight")
     {
       owner.pending_weight_request_[bank_id] = true;
-      wt_total_cycle[bank_id]                = gSim->getCurTick() - wt_current_cycle[bank_id];
+      owner.wt_total_cycle[bank_id]          = gSim->getCurTick() - owner.wt_current_cycle[bank_id];
     }
     else if (bank_name == "feature")
     {
       owner.pending_feature_request_[bank_id]  = true;
-      fw_total_cycle[bank_id]                 += gSim->getCurTick() - fw_current_cycle[bank_id];
+      owner.fw_total_cycle[bank_id]           += gSim->getCurTick() - owner.fw_current_cycle[bank_id];
     }
     owner.scheduleTickIfNeeded(1);  // 立即安排下一拍的 Tick 尝试重发
   }
@@ -108,12 +105,11 @@ namespace GNN
 
   DecoderModule::DecoderModule(const std::string& name,
                                int                active_banks,
-                               SimDramStorage*    sim_dram_storage,
                                Buffer*            write_buffer)
-    : SimObject(name), active_banks_(active_banks), sim_dram_storage_(sim_dram_storage),
-      write_buffer_(write_buffer), tickEvent([this] { tick(); }, name + ".tickEvent"),
-      retry2CamEvent([this] { retry2CamTick(); }, name + ".retry2CamEvent"),
-      clearCamEvent([this] { clearCamtick(); }, name + ".clearCamEvent")
+    : SimObject(name), active_banks_(active_banks),
+      write_buffer_(write_buffer), tickEvent(*this, "tickEvent"),
+      retry2CamEvent(*this, "retry2CamEvent"),
+      clearCamEvent(*this, "clearCamEvent")
   {
     // OUT.open("./result/EDR/033_test_qkv_mac_u.txt", std::ios::trunc);
     // if (!OUT) {
@@ -146,6 +142,12 @@ namespace GNN
     in_flight_.assign(active_banks_, false);
     weight_in_flight_.assign(active_banks_, false);
     feature_in_flight_.assign(active_banks_, false);
+    bm_total_cycle.assign(active_banks_, 0);
+    wt_total_cycle.assign(active_banks_, 0);
+    fw_total_cycle.assign(active_banks_, 0);
+    bm_current_cycle.assign(active_banks_, 0);
+    wt_current_cycle.assign(active_banks_, 0);
+    fw_current_cycle.assign(active_banks_, 0);
     hash_cam_.resize(active_banks_);
 
     // ===== 关键修复：先 resize 计算状态向量 =====
@@ -184,7 +186,7 @@ namespace GNN
 
       file_stall[i].final_addr =
         ((file_stall[i].file_slice_row * file_stall[i].file_slice_col / BURST_BITS) *
-         INST_ADDR_STRIDE) +
+         instAddrStride()) +
         i * CHANNEL_ADDR_DIF;
 
       D_DEBUG("BLOCK",
@@ -203,7 +205,7 @@ namespace GNN
 
       // ===== 现在可以安全初始化计算状态 =====
       compute_block_states_[i].reset();
-      current_block_configs_[i] = param_config.computeBlockConfig(SRAM_CAPACITY);
+      current_block_configs_[i] = param_config.computeBlockConfig(SRAM_CAPACITY, active_banks_);
       compute_block_states_[i].total_feature_blocks =
         current_block_configs_[i].total_feature_blocks;
       compute_block_states_[i].total_weight_blocks = current_block_configs_[i].total_weight_blocks;
@@ -234,6 +236,16 @@ namespace GNN
             32);
   }
 
+  void DecoderModule::releasePackets()
+  {
+    // 解码到一半的 bitmap 包
+    for (auto& state : bank_states_)
+    {
+      PacketManager::free_packet(state.bitmap_pkt);
+      state.bitmap_pkt = nullptr;
+    }
+  }
+
   void DecoderModule::resetBankState(int bank_id)
   {
     bank_states_[bank_id]                    = {};                    // 重置为默认值
@@ -248,6 +260,8 @@ namespace GNN
 
   void DecoderModule::scheduleTickIfNeeded(uint32_t delay)
   {
+    if (held_)
+      return;
     if (!tickEvent.scheduled())
     {
       schedule(tickEvent, curTick() + delay);
@@ -318,11 +332,11 @@ namespace GNN
           // 发送 Weight 请求 (拉取当前周期的数据)
           D_DEBUG("DECODER", "Bank %d: Sending Weight and Feature request", bank);
 
-          PacketPtr w_req = PacketManager::create_read_packet(0x1000000, BURST_BITS / STORAGE_SIZE);
-          PacketPtr f_req = PacketManager::create_read_packet(0x2000000, BURST_BITS / STORAGE_SIZE);
+          // 请求包只在真正发送时创建：上一拍已发出的一侧本拍不再发送，成功标志仍为真
           if (!bank_states_[bank].weight_received && !weight_in_flight_[bank] &&
               pending_weight_request_[bank])
           {
+            PacketPtr w_req = PacketManager::create_read_packet(0x1000000, BURST_BITS / STORAGE_SIZE);
             if (bank_wf_request_info_[bank].weight_is_empty)
             {
               bank_wf_request_info_[bank].weight_is_empty = false;
@@ -339,6 +353,7 @@ namespace GNN
             {
               wt_current_cycle[bank]        = gSim->getCurTick();
               pending_weight_request_[bank] = false;
+              PacketManager::free_packet(w_req);
             }
             D_DEBUG("DECODER",
                     "Bank %d: Weight request success: %d",
@@ -349,6 +364,7 @@ namespace GNN
               pending_feature_request_[bank])
           {
             // 发送 Feature 请求
+            PacketPtr f_req = PacketManager::create_read_packet(0x2000000, BURST_BITS / STORAGE_SIZE);
             if (bank_wf_request_info_[bank].feature_is_clear)
             {
               bank_wf_request_info_[bank].feature_is_clear = false;
@@ -365,6 +381,7 @@ namespace GNN
               fw_current_cycle[bank] = gSim->getCurTick();
               D_DEBUG("DECODER", "Bank %d: Feature request failed, retrying later", bank);
               pending_feature_request_[bank] = false;
+              PacketManager::free_packet(f_req);
             }
             D_DEBUG("DECODER",
                     "Bank %d: Feature request success: %d",
@@ -389,19 +406,9 @@ namespace GNN
             weight_success[bank]     = false;
             feature_success[bank]    = false;
           }
-          else
+          else if (!weight_success[bank] && bank == 6)
           {
-            // 如果有一个失败，则全部释放
-            if (!weight_success[bank])
-            {
-              if (bank == 6)
-                D_DEBUG("DECODER", "Bank %d: Weight request failed, retrying later", bank);
-              PacketManager::free_packet(w_req);
-            }
-            if (!feature_success[bank])
-            {
-              PacketManager::free_packet(f_req);
-            }
+            D_DEBUG("DECODER", "Bank %d: Weight request failed, retrying later", bank);
           }
         }
         else
@@ -457,12 +464,7 @@ namespace GNN
     in_flight_[bank_id] = false;
 
     // 2. 解码/解压 (模拟功能)
-    // 从模拟DRAM读取bitmap数据到pkt，并统计1的数量
-    D_DEBUG("DECODER",
-            "Bank %d: Reading bitmap data from SIM_DRAM_STORAGE, addr: %d",
-            bank_id,
-            pkt->getAddr());
-    sim_dram_storage_->readPacket(pkt);
+    // 包内数据已由 DramArb 在读响应时从存储填好，经 DMA 缓冲原包转交，这里直接解码并统计1的数量
     bank_states_[bank_id].bitmap_pkt = pkt;
     // 统计1的数量（每个元素代表16位=一行）
     const auto& bitmap_words         = pkt->getData();
@@ -944,7 +946,7 @@ namespace GNN
               file_stall[bank_id].final_slice_row * file_stall[bank_id].file_slice_col / BURST_BITS;
             file_stall[bank_id].final_addr = ((file_stall[bank_id].final_slice_row *
                                                file_stall[bank_id].file_slice_col / BURST_BITS) *
-                                              INST_ADDR_STRIDE) +
+                                              instAddrStride()) +
                                              bank_id * CHANNEL_ADDR_DIF;
           }
           else
@@ -953,7 +955,7 @@ namespace GNN
               file_stall[bank_id].file_slice_row * file_stall[bank_id].file_slice_col / BURST_BITS;
             file_stall[bank_id].final_addr = ((file_stall[bank_id].file_slice_row *
                                                file_stall[bank_id].file_slice_col / BURST_BITS) *
-                                              INST_ADDR_STRIDE) +
+                                              instAddrStride()) +
                                              bank_id * CHANNEL_ADDR_DIF;
           }
 
@@ -1031,7 +1033,7 @@ namespace GNN
               file_stall[bank_id].file_slice_row * file_stall[bank_id].file_slice_col / BURST_BITS;
             file_stall[bank_id].final_addr = ((file_stall[bank_id].file_slice_row *
                                                file_stall[bank_id].file_slice_col / BURST_BITS) *
-                                              INST_ADDR_STRIDE) +
+                                              instAddrStride()) +
                                              bank_id * CHANNEL_ADDR_DIF;
             D_DEBUG("BLOCK",
                     "Bank %d: Switched to '%s' (dim %ux%u), total_slices=%d",
@@ -1052,7 +1054,7 @@ namespace GNN
 
             // ===== 现在可以安全初始化计算状态 =====
             compute_block_states_[bank_id].reset();
-            current_block_configs_[bank_id] = next_param.computeBlockConfig(SRAM_CAPACITY);
+            current_block_configs_[bank_id] = next_param.computeBlockConfig(SRAM_CAPACITY, active_banks_);
             compute_block_states_[bank_id].total_feature_blocks =
               current_block_configs_[bank_id].total_feature_blocks;
             compute_block_states_[bank_id].total_weight_blocks =
@@ -1064,6 +1066,8 @@ namespace GNN
                     compute_block_states_[bank_id].total_feature_blocks,
                     compute_block_states_[bank_id].total_weight_blocks);
           }
+          if (current_param_idx_ == hold_param_)
+            held_ = true;
           scheduleTickIfNeeded(1);
         }
         else
@@ -1247,7 +1251,7 @@ namespace GNN
 
     if (gSim->getCurTick() % 1000 == 0)
     {
-      const size_t kCh                     = 8;
+      const size_t kCh                     = active_banks_;
       uint64_t     sum_total               = 0;
       uint64_t     sum_cam_full            = 0;
       uint64_t     sum_emit_single         = 0;
@@ -1276,10 +1280,10 @@ namespace GNN
         (double)(sum_emit_full_paired * 2 + sum_emit_disfull_paired * 2) /
         (double)(sum_emit_full_paired * 2 + sum_emit_disfull_paired * 2 + sum_emit_single) * 100.0;
 
-      uint64_t dram_bw = dram_burst_num * 2 / 8;
+      uint64_t dram_bw = dram_burst_num * 2 / kCh;
       double   dram_u  = (double)dram_bw / gSim->getCurTick() * 100;
       double   mac_u =
-        (double)FW_ROW_SIZE * cal_cycle / gSim->getCurTick() / CHANNEL_NUM / MAC_NUM * 100;
+        (double)FW_ROW_SIZE * cal_cycle / gSim->getCurTick() / kCh / MAC_NUM * 100;
       OUT << gSim->getCurTick() << "," << mac_u << std::endl;
       OUT3 << gSim->getCurTick() << "," << dram_u << std::endl;
       OUT1 << gSim->getCurTick() << "," << total_proportion_ratio << std::endl;
@@ -1799,8 +1803,8 @@ namespace GNN
     // double emit_single_ratio = (double)stats.emit_single_cycles / stats.total_cycles * 100.0;
     // double emit_paired_full_ratio = (double)stats.emit_paired_full_cycles / stats.total_cycles * 100.0;
 
-    // --- 8通道加权平均(按 total_cycles 加权) ---
-    const size_t kCh                     = 8;
+    // --- 各通道加权平均(按 total_cycles 加权) ---
+    const size_t kCh                     = active_banks_;
     uint64_t     sum_total               = 0;
     uint64_t     sum_cam_full            = 0;
     uint64_t     sum_emit_single         = 0;
@@ -1835,7 +1839,7 @@ namespace GNN
                 stats.current_rd_addr,
                 GNN::storage_addr_max);
 
-    for (int i = 0; i < 8; i++)
+    for (int i = 0; i < active_banks_; i++)
     {
       D_INFO("RESULT", "bm_total_cycle[%d] %d", i, bm_total_cycle[i]);
       D_INFO("RESULT", "wt_total_cycle[%d] %d", i, wt_total_cycle[i]);
@@ -1862,14 +1866,14 @@ namespace GNN
                 "RESULT",
                 "[Bank %zu] CAM full cycles: %llu (%.2f%%)",
                 bank_id,
-                sum_cam_full / 8,
+                sum_cam_full / kCh,
                 cam_full_ratio);
     D_BANK_INFO(
       bank_id,
       "RESULT",
       "[Bank %zu] Emit single cycles: %llu (%.2f%%) Single Emit average MAC count : % .2f ",
       bank_id,
-      sum_emit_single / 8,
+      sum_emit_single / kCh,
       emit_single_ratio,
       (double)(cal_cycle - sum_emit_full_paired * 8) /
         (double)(sum_emit_single + sum_emit_disfull_paired));
@@ -1877,14 +1881,14 @@ namespace GNN
                 "RESULT",
                 "[Bank %zu] Emit paired disfull cycles: %llu (%.2f%%)",
                 bank_id,
-                sum_emit_disfull_paired / 8,
+                sum_emit_disfull_paired / kCh,
                 emit_paired_disfull_ratio);
 
     D_BANK_INFO(bank_id,
                 "RESULT",
                 "[Bank %zu] Emit paired full cycles: %llu (%.2f%%)",
                 bank_id,
-                sum_emit_full_paired / 8,
+                sum_emit_full_paired / kCh,
                 emit_paired_full_ratio);
 
     D_BANK_INFO(
@@ -1899,13 +1903,13 @@ namespace GNN
         (double)(sum_emit_full_paired + sum_emit_disfull_paired + sum_emit_single));
     D_BANK_INFO(
       bank_id, "RESULT", "big 16 mac proportion: %.2f%%", (double)d16_cnt / a16_cnt * 100);
-    uint64_t dram_bw = dram_burst_num * 2 / 8;
+    uint64_t dram_bw = dram_burst_num * 2 / kCh;
     double   dram_u  = (double)dram_bw / stats.total_cycles;
-    double   mac_u   = (double)FW_ROW_SIZE * cal_cycle / stats.total_cycles / CHANNEL_NUM / MAC_NUM;
+    double   mac_u   = (double)FW_ROW_SIZE * cal_cycle / stats.total_cycles / kCh / MAC_NUM;
     double   real_mac_u =
-      (double)FW_ROW_SIZE * totall_num_output / stats.total_cycles / CHANNEL_NUM / MAC_NUM;
+      (double)FW_ROW_SIZE * totall_num_output / stats.total_cycles / kCh / MAC_NUM;
 
-    D_BANK_INFO(bank_id, "RESULT", "MAC cycle: %llu  cycle", cal_cycle / 8);
+    D_BANK_INFO(bank_id, "RESULT", "MAC cycle: %llu  cycle", cal_cycle / kCh);
     D_BANK_INFO(bank_id, "RESULT", "DRAM Output Bytes Number : %llu  cycle", dram_bw);
     D_BANK_INFO(bank_id, "RESULT", "Real MAC BW: %.2f%%  cycle", real_mac_u * 100);
     D_BANK_INFO(bank_id, "RESULT", "MAC BW :  %.2f%% ", mac_u * 100);
@@ -1970,25 +1974,25 @@ namespace GNN
     // bitmapRequestPorts[idx].name().c_str());
     if (if_name.rfind(bitmapRequestPorts[idx].name(), 0) == 0)
     {
-      int bank = std::stoi(if_name.substr(if_name.length() - 1));
+      int bank = portIndexSuffix(if_name);
       if (bank >= 0 && bank < active_banks_)
         return bitmapRequestPorts[bank];
     }
     if (if_name.rfind(featureRequestPorts[idx].name(), 0) == 0)
     {
-      int bank = std::stoi(if_name.substr(if_name.length() - 1));
+      int bank = portIndexSuffix(if_name);
       if (bank >= 0 && bank < active_banks_)
         return featureRequestPorts[bank];
     }
     if (if_name.rfind(weightRequestPorts[idx].name(), 0) == 0)
     {
-      int bank = std::stoi(if_name.substr(if_name.length() - 1));
+      int bank = portIndexSuffix(if_name);
       if (bank >= 0 && bank < active_banks_)
         return weightRequestPorts[bank];
     }
     if (if_name.rfind(computresponsePort[idx].name(), 0) == 0)
     {
-      int bank = std::stoi(if_name.substr(if_name.length() - 1));
+      int bank = portIndexSuffix(if_name);
       if (bank >= 0 && bank < active_banks_)
         return computresponsePort[bank];
     }
@@ -2010,7 +2014,7 @@ namespace GNN
       bool   sent = write_buffer_->enqueueWrite(bank_id, addr, payload);
       if (sent)
       {
-        next_write_addr_[bank_id] += INST_ADDR_STRIDE;
+        next_write_addr_[bank_id] += instAddrStride();
         D_DEBUG("DECODER",
                 "Bank %u: Enqueued %zu words to Buffer at addr 0x%x",
                 bank_id,
@@ -2030,4 +2034,181 @@ namespace GNN
   // (这里是 Port 内部类，需要根据 BankName 映射回类型)
   // 注意：由于在 Port 构造函数中传入了类型，这里简化处理 Port 内部的
   // recvTimingResp 确保 BankRequestPort 构造时传入了正确的类型字符串。
+
+  void DecoderModule::holdAtParam(size_t param_idx)
+  {
+    hold_param_ = param_idx;
+    if (current_param_idx_ == param_idx)
+      held_ = true;
+  }
+
+  void DecoderModule::resume()
+  {
+    held_ = false;
+    scheduleTickIfNeeded(1);
+  }
+
+  void DecoderModule::serialize(SectionOut& os) const
+  {
+    assert(held_);
+    os.put(static_cast<int32_t>(active_banks_));
+    os.put(current_param_idx_);
+    os.put(file_stall);
+    os.put(weight_success);
+    os.put(feature_success);
+    os.put(adder_fifos);
+    for (const DecodedBlockInfo& st : bank_states_)
+    {
+      os.put(st.current_cmd_id);
+      os.put(st.total_elements);
+      os.put(st.processed_count);
+      os.put(st.elements_per_cycle);
+      os.put(st.ones_in_bitmap);
+      os.put(st.bitmap_pkt);
+      os.put(st.row_ones_counts);
+      os.put(st.row_bits_data);
+      os.put(st.total_rows);
+      os.put(st.total_words);
+      os.put(st.processed_words);
+      os.put(st.state);
+      os.put(st.weight_received);
+      os.put(st.feature_received);
+      os.put(st.bitmap_processing_complete);
+    }
+    os.put(bank_wf_request_info_);
+    os.put(next_write_addr_);
+    os.put(add_stall_cycle_);
+    os.put(Info2Cam_);
+    // 桶的遍历次序影响配对与驱逐时先找到哪一项，连同桶数一起保存
+    for (const auto& cams : hash_cam_)
+    {
+      for (const CamBank& cam : cams)
+      {
+        os.put(static_cast<uint64_t>(cam.buckets.bucket_count()));
+        os.put(static_cast<uint64_t>(cam.buckets.size()));
+        for (const auto& kv : cam.buckets)
+        {
+          os.put(kv.first);
+          os.put(kv.second);
+        }
+        os.put(static_cast<uint64_t>(cam.size));
+      }
+    }
+    os.put(hash_cam_perf_stats_);
+    os.put(totall_num_output);
+    os.put(totall_num_input);
+    os.put(emitted0_hist_);
+    os.put(current_addr);
+    os.put(pending_request_);
+    os.put(pending_weight_request_);
+    os.put(pending_feature_request_);
+    os.put(in_flight_);
+    os.put(weight_in_flight_);
+    os.put(feature_in_flight_);
+    os.put(bm_total_cycle);
+    os.put(wt_total_cycle);
+    os.put(fw_total_cycle);
+    os.put(bm_current_cycle);
+    os.put(wt_current_cycle);
+    os.put(fw_current_cycle);
+    os.put(compute_block_states_);
+    os.put(current_block_configs_);
+    // 本文件内的全局计数
+    os.put(addr_num);
+    os.put(cal_cycle);
+    os.put(d16_cnt);
+    os.put(a16_cnt);
+    os.put(retry_num);
+    os.put(cnta);
+    os.put(his_cycle);
+    os.put(parid_sub);
+    os.put(cntb);
+  }
+
+  void DecoderModule::unserialize(SectionIn& is)
+  {
+    if (is.get<int32_t>() != active_banks_)
+      throw std::runtime_error(name() + ": checkpoint bank count mismatch");
+    is.get(current_param_idx_);
+    is.get(file_stall);
+    is.get(weight_success);
+    is.get(feature_success);
+    is.get(adder_fifos);
+    releasePackets();
+    for (DecodedBlockInfo& st : bank_states_)
+    {
+      is.get(st.current_cmd_id);
+      is.get(st.total_elements);
+      is.get(st.processed_count);
+      is.get(st.elements_per_cycle);
+      is.get(st.ones_in_bitmap);
+      is.get(st.bitmap_pkt);
+      is.get(st.row_ones_counts);
+      is.get(st.row_bits_data);
+      is.get(st.total_rows);
+      is.get(st.total_words);
+      is.get(st.processed_words);
+      is.get(st.state);
+      is.get(st.weight_received);
+      is.get(st.feature_received);
+      is.get(st.bitmap_processing_complete);
+    }
+    is.get(bank_wf_request_info_);
+    is.get(next_write_addr_);
+    is.get(add_stall_cycle_);
+    is.get(Info2Cam_);
+    for (auto& cams : hash_cam_)
+    {
+      for (CamBank& cam : cams)
+      {
+        size_t bucket_count = static_cast<size_t>(is.get<uint64_t>());
+        std::vector<std::pair<int, std::deque<CamEntry>>> entries(is.get<uint64_t>());
+        for (auto& kv : entries)
+        {
+          is.get(kv.first);
+          is.get(kv.second);
+        }
+        // 同桶数下逆序插入即还原保存时的遍历次序（新节点插在所在桶的最前面）；
+        // 从未插入过的表只有一个内置桶，rehash 还原不出来，直接换成新表
+        decltype(cam.buckets)().swap(cam.buckets);
+        if (bucket_count > 1)
+          cam.buckets.rehash(bucket_count);
+        for (auto it = entries.rbegin(); it != entries.rend(); ++it)
+          cam.buckets.emplace(it->first, std::move(it->second));
+        if (cam.buckets.bucket_count() != bucket_count)
+          throw std::runtime_error(name() + ": cannot rebuild hash CAM bucket layout");
+        cam.size = static_cast<size_t>(is.get<uint64_t>());
+      }
+    }
+    is.get(hash_cam_perf_stats_);
+    is.get(totall_num_output);
+    is.get(totall_num_input);
+    is.get(emitted0_hist_);
+    is.get(current_addr);
+    is.get(pending_request_);
+    is.get(pending_weight_request_);
+    is.get(pending_feature_request_);
+    is.get(in_flight_);
+    is.get(weight_in_flight_);
+    is.get(feature_in_flight_);
+    is.get(bm_total_cycle);
+    is.get(wt_total_cycle);
+    is.get(fw_total_cycle);
+    is.get(bm_current_cycle);
+    is.get(wt_current_cycle);
+    is.get(fw_current_cycle);
+    is.get(compute_block_states_);
+    is.get(current_block_configs_);
+    is.get(addr_num);
+    is.get(cal_cycle);
+    is.get(d16_cnt);
+    is.get(a16_cnt);
+    is.get(retry_num);
+    is.get(cnta);
+    is.get(his_cycle);
+    is.get(parid_sub);
+    is.get(cntb);
+    // 恢复后与保存时一样停在参数边界，由 resume() 继续
+    held_ = true;
+  }
 }  // namespace GNN
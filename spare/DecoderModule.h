@@ -56,7 +56,7 @@ namespace GNN
     uint32_t file_slice_col;  // 单次读取的 Weight 列数
 
     // 计算分块信息的函数
-    MatrixBlockConfig computeBlockConfig(uint32_t sram_capacity) const
+    MatrixBlockConfig computeBlockConfig(uint32_t sram_capacity, int channels = CHANNEL_NUM) const
     {
       MatrixBlockConfig cfg;
       cfg.total_input_dim    = file_total_row;
@@ -71,7 +71,7 @@ namespace GNN
       // 例如: 4100行, 512行/块 -> (4100+512-1)/512 = 4611/512 = 9块
       cfg.total_feature_blocks = (file_total_row + file_slice_row - 1) / file_slice_row;
       cfg.total_weight_blocks =
-        (file_total_col + file_slice_col * CHANNEL_NUM - 1) / (file_slice_col * CHANNEL_NUM);
+        (file_total_col + file_slice_col * channels - 1) / (file_slice_col * channels);
 
       return cfg;
     }
@@ -222,11 +222,10 @@ namespace GNN
   public:
     DecoderModule(const std::string& name,
                   int                active_banks,
-                  SimDramStorage*    sim_dram_storage,
                   Buffer*            write_buffer);
 
-    SimDramStorage* sim_dram_storage_;
     void            init() override;
+    void            releasePackets() override;
 
     // 设置下一个 HxW 块的起始命令 (由 Sparsity Scheduler 触发)
     void                   startNewBlock(uint64_t cmd_id, address_t base_addr);
@@ -238,6 +237,8 @@ namespace GNN
     std::ofstream                                  OUT1;
     std::ofstream                                  OUT2;
     int                                            active_banks_;
+    // 一条指令的地址步长：每个通道各一行，随运行时通道数变化
+    addr_t instAddrStride() const { return static_cast<addr_t>(active_banks_) * CHANNEL_ADDR_DIF; }
     std::vector<bool>                              weight_success;
     std::vector<std::vector<std::deque<uint32_t>>> adder_fifos;
     Buffer*                                        write_buffer_;
@@ -317,16 +318,19 @@ namespace GNN
     std::vector<bool>    in_flight_;                // 标记请求是否已发出，等待响应
     std::vector<bool>    weight_in_flight_;         // 标记权重请求是否已发出，等待响应
     std::vector<bool>    feature_in_flight_;        // 标记特征请求是否已发出，等待响应
-    // 定时事件：驱动请求发送和状态机 Tick
-    EventFunctionWrapper tickEvent;
-    EventFunctionWrapper retry2CamEvent;
-    EventFunctionWrapper clearCamEvent;
+    // 每个 bank 请求被拒绝到收到重试之间的等待周期统计
+    std::vector<uint64_t> bm_total_cycle, wt_total_cycle, fw_total_cycle;
+    std::vector<uint64_t> bm_current_cycle, wt_current_cycle, fw_current_cycle;
     void                 retry2CamTick();
     void                 scheduleRetry2CamIfNeeded(uint32_t delay);
     void                 tick();
     void                 scheduleTickIfNeeded(uint32_t delay);
     void                 scheduleClearCamTick(uint32_t delay);
     void                 clearCamtick();
+    // 定时事件：驱动请求发送和状态机 Tick
+    MemberEventWrapper<&DecoderModule::tick>          tickEvent;
+    MemberEventWrapper<&DecoderModule::retry2CamTick> retry2CamEvent;
+    MemberEventWrapper<&DecoderModule::clearCamtick>  clearCamEvent;
     void sendResultToBuffer(uint32_t bank_id, const std::vector<storage_t>& payload);
 
     // ========= 请求端口定义 (向 Banks 拉取数据) =========
@@ -380,10 +384,22 @@ namespace GNN
     void  printHashCamPerfStats(uint32_t bank_id);
     void  exportHashCamPerfStats(const std::string& filename);
 
+    // 检查点：暂停发起新请求，等其余模块排空后由 resume() 继续，排空的这一刻即保存
+    // 检查点的边界。hold() 立即暂停，holdAtParam() 在切换到第 param_idx 个参数时暂停
+    void   hold() { held_ = true; }
+    void   holdAtParam(size_t param_idx);
+    bool   held() const { return held_; }
+    size_t paramIndex() const { return current_param_idx_; }
+    void   resume();
+    void   serialize(SectionOut& os) const override;
+    void   unserialize(SectionIn& is) override;
+
   private:
     // ===== 参数轮询相关 =====
     size_t current_param_idx_ = 0;
     size_t total_params_      = LLAMA_7B_PARAMS.size();
+    size_t hold_param_        = SIZE_MAX;
+    bool   held_              = false;
 
     // ===== 计算状态管理（每个 Bank） =====
     std::vector<ComputeBlockState> compute_block_states_;
@@ -439,7 +455,7 @@ namespace GNN
       for (size_t i = 0; i < compute_block_states_.size(); ++i)
       {
         compute_block_states_[i].reset();
-        current_block_configs_[i] = param.computeBlockConfig(SRAM_CAPACITY);
+        current_block_configs_[i] = param.computeBlockConfig(SRAM_CAPACITY, active_banks_);
         compute_block_states_[i].total_feature_blocks =
           current_block_configs_[i].total_feature_blocks;
         compute_block_states_[i].total_weight_blocks =
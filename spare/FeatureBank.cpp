@@ -19,8 +19,9 @@ namespace GNN
 
   void FeatureBank::init()
   {
-    startNextDmaCommand();
-    startNextDmaCommand();
+    DmaBuffer::init();
+    for (int i = 0; i < bufferDepth(); ++i)
+      startNextDmaCommand();
   }
 
   bool FeatureBank::recvTimingReq(PacketPtr pkt, uint32_t bank_id)
@@ -33,6 +34,8 @@ namespace GNN
 
     for (int i = 0; i < active_banks_; ++i)
     {
+      if (isFunctional())
+        fetchFunctional(i);
       int idx = getReadableBufferIndex(i);
       if (idx < 0)
       {
@@ -59,12 +62,12 @@ namespace GNN
   {
     for (int i = 0; i < active_banks_; ++i)
     {
-      if (inst_cnts_[i] >= 2)
+      if (inst_cnts_[i] >= bufferDepth())
       {
-        D_WARN("FeatureBank", "Bank%d instruction counter full (inst_cnt=2)", i);
+        D_WARN("FeatureBank", "Bank%d instruction counter full (inst_cnt=%d)", i, inst_cnts_[i]);
         continue;
       }
-      addr_t addr = base_addr_ + cmd_id_cnts_[i] * INST_ADDR_STRIDE * burst_num_;
+      addr_t addr = base_addr_ + cmd_id_cnts_[i] * addr_stride_ * burst_num_;
       startFeatureLoadCommand(cmd_id_cnts_[i]++, addr, burst_num_, i);
     }
   }
@@ -86,7 +89,7 @@ namespace GNN
   void FeatureBank::CompleteCommand(uint64_t bank_id)
   {
     // if (cmd_id_cnts_[bank_id] < TOTAL_INST_NUM_CFG * 100) {
-    addr_t addr = base_addr_ + cmd_id_cnts_[bank_id] * INST_ADDR_STRIDE * burst_num_;
+    addr_t addr = base_addr_ + cmd_id_cnts_[bank_id] * addr_stride_ * burst_num_;
     startFeatureLoadCommand(cmd_id_cnts_[bank_id]++, addr, burst_num_, bank_id);
     // }
   }
@@ -102,7 +105,7 @@ namespace GNN
       if (idx < 0)
         continue;
 
-      assert(!bank_controllers_[bank].buffers[idx].dma_pkt.empty());
+      assert(!bank_controllers_[bank].buffers[idx].drained());
 
       PacketPtr pkt = req_pkt_[bank];
       if (computePorts[bank].sendTimingResp(pkt))
@@ -150,4 +153,18 @@ namespace GNN
     return DmaBuffer::getPort(if_name, idx);
   }
 
+  void FeatureBank::serialize(SectionOut &os) const
+  {
+    DmaBuffer::serialize(os);
+    os.put(cmd_id_cnts_);
+    os.put(buffer_is_clear_flag);
+  }
+
+  void FeatureBank::unserialize(SectionIn &is)
+  {
+    DmaBuffer::unserialize(is);
+    is.get(cmd_id_cnts_);
+    is.get(buffer_is_clear_flag);
+  }
+
 } // namespace GNN
\ No newline at end of file
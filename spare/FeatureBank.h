@@ -21,6 +21,8 @@ public:
     void sendRespond() override;
     bool recvTimingReq(PacketPtr pkt, uint32_t bank_id) override;
     Port &getPort(const std::string &if_name, int idx = -1) override;
+    void serialize(SectionOut &os) const override;
+    void unserialize(SectionIn &is) override;
 
 private:
     void startNextDmaCommand();
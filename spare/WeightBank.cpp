@@ -8,6 +8,7 @@
  */
 #include "WeightBank.h"
 #include "../common/debug.h"
+#include <cassert>
 
 namespace GNN {
 
@@ -21,17 +22,31 @@ WeightBank::WeightBank(const std::string &name, addr_t base_addr, int burst_num,
 }
 
 void WeightBank::init() {
-  startNextDmaCommand();
-  startNextDmaCommand();
+  DmaBuffer::init();
+  for (int i = 0; i < bufferDepth(); ++i)
+    startNextDmaCommand();
+}
+
+void WeightBank::setRowMajorLayout(int row_pitch) {
+  assert(row_pitch >= 0);
+  row_pitch_ = row_pitch;
+}
+
+addr_t WeightBank::commandAddr(uint64_t cmd_id) const {
+  if (row_pitch_ == 0)
+    return base_addr_ + cmd_id * addr_stride_ * burst_num_;
+  uint64_t tile_row = cmd_id / row_pitch_;
+  uint64_t tile_col = cmd_id % row_pitch_;
+  return base_addr_ + (tile_row * burst_num_ * row_pitch_ + tile_col) * addr_stride_;
 }
 
 void WeightBank::startNextDmaCommand() {
   for (int i = 0; i < active_banks_; ++i) {
-    if (inst_cnts_[i] >= 2) {
-      D_WARN("WeightBank", "Bank%d instruction counter full (inst_cnt=2)", i);
+    if (inst_cnts_[i] >= bufferDepth()) {
+      D_WARN("WeightBank", "Bank%d instruction counter full (inst_cnt=%d)", i, inst_cnts_[i]);
       continue;
     }
-    addr_t addr = base_addr_ + cmd_id_cnts_[i] * INST_ADDR_STRIDE * burst_num_;
+    addr_t addr = commandAddr(cmd_id_cnts_[i]);
     startWeightLoadCommand(cmd_id_cnts_[i]++, addr, burst_num_, i);
   }
 }
@@ -43,6 +58,11 @@ void WeightBank::startWeightLoadCommand(uint64_t cmd_id, addr_t base_addr,
   cmd.cmd_id = cmd_id;
   cmd.base_addr = base_addr;
   cmd.total_lines = total_lines;
+  if (row_pitch_ > 0) {
+    cmd.rows = total_lines;
+    cmd.total_lines = 1;
+    cmd.row_stride = static_cast<addr_t>(row_pitch_) * addr_stride_;
+  }
   D_INFO("INST", "Bank %d: Start cmd %lu, addr=0x%x, lines=%d  %s", 
          bank_id, cmd_id, base_addr, total_lines,name().c_str());
   enqueueCommand(cmd);
@@ -50,7 +70,7 @@ void WeightBank::startWeightLoadCommand(uint64_t cmd_id, addr_t base_addr,
 
 void WeightBank::CompleteCommand(uint64_t bank_id) {
   // if (cmd_id_cnts_[bank_id] < TOTAL_INST_NUM_CFG * 100) {
-    addr_t addr = base_addr_ + cmd_id_cnts_[bank_id] * INST_ADDR_STRIDE * burst_num_;
+    addr_t addr = commandAddr(cmd_id_cnts_[bank_id]);
     startWeightLoadCommand(cmd_id_cnts_[bank_id]++, addr, burst_num_, bank_id);
   // }
 }
@@ -61,7 +81,7 @@ void WeightBank::sendRespond() {
     int idx = getReadableBufferIndex(bank);
     if (idx < 0) continue;
     
-    assert(!bank_controllers_[bank].buffers[idx].dma_pkt.empty());
+    assert(!bank_controllers_[bank].buffers[idx].drained());
     
     PacketPtr pkt = req_pkt_[bank];
     if (computePorts[bank].sendTimingResp(pkt)) {
@@ -84,4 +104,14 @@ Port &WeightBank::getPort(const std::string &if_name, int idx) {
   return DmaBuffer::getPort(if_name, idx);
 }
 
+void WeightBank::serialize(SectionOut &os) const {
+  DmaBuffer::serialize(os);
+  os.put(cmd_id_cnts_);
+}
+
+void WeightBank::unserialize(SectionIn &is) {
+  DmaBuffer::unserialize(is);
+  is.get(cmd_id_cnts_);
+}
+
 } // namespace GNN
\ No newline at end of file
@@ -10,6 +10,7 @@ namespace GNN {
 class WeightBank : public DmaBuffer {
 private:
     std::vector<uint64_t> cmd_id_cnts_;
+    int row_pitch_ = 0;
     EventFunctionWrapper selfScheduleEvent;
     
 public:
@@ -19,8 +20,15 @@ public:
     void CompleteCommand(uint64_t bank_id) override;
     void sendRespond() override;
     Port &getPort(const std::string &if_name, int idx = -1) override;
+    void serialize(SectionOut &os) const override;
+    void unserialize(SectionIn &is) override;
+    // 权重按原矩阵行主序存放：矩阵一行占 row_pitch 个 bank 行，每个切片是其中一列 bank 行宽的
+    // 列块，按 2D 描述符逐行跨步取；0（默认）为切片预先按块连续打包，线性取
+    void setRowMajorLayout(int row_pitch);
 
 private:
+    // 第 cmd_id 条命令的起始地址：行主序下先走完一行切片的各列块，再换下一组切片行
+    addr_t commandAddr(uint64_t cmd_id) const;
     void startNextDmaCommand();
     void startWeightLoadCommand(uint64_t cmd_id, addr_t base_addr, int total_lines, int bank_id);
 };
@@ -0,0 +1,26 @@
+#!/bin/bash
+# 检查点自检：在第 tick 周期暂停排空后保存检查点并继续跑完，再从检查点恢复跑完，两次的后续输出须一致
+# 用法：checkpoint_test.sh <模拟器> [通道数=8] [tick=20000]，在含 data/ 与 DRAMsim3 配置的目录下运行，退出码 0 为通过
+set -u
+sim=$1
+channels=${2:-8}
+tick=${3:-20000}
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+
+# 标记行之后的输出，去掉随宿主机变化的行
+after() { sed -n "/^---- $1 /,\$p" "$2" | tail -n +2 | grep -v -e '^PacketPool' -e 'host_ms'; }
+
+if ! "$sim" "$channels" checkpoint "$tick" "$dir/run.ckpt" >"$dir/checkpoint.out"; then
+  echo "FAIL checkpoint run"
+  exit 1
+fi
+if ! "$sim" "$channels" restore "$dir/run.ckpt" >"$dir/restore.out"; then
+  echo "FAIL restore run"
+  exit 1
+fi
+if ! diff <(after Checkpoint "$dir/checkpoint.out") <(after Restored "$dir/restore.out"); then
+  echo "FAIL restored run differs"
+  exit 1
+fi
+echo "checkpoint test PASSED"
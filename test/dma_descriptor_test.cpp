@@ -0,0 +1,111 @@
+// DmaCommand 描述符自检：2D 跨步 + 分散/聚集链、行主序权重命令与等长线性命令取到同一串行地址；流检测的认定
+// 构建：与 dma/*.cpp event/*.cpp common/*.cpp dram/addr_map.cpp 一起编译链接，退出码 0 为通过
+#include "../common/define.h"
+#include "../dma/DmaBuffer.h"
+#include "../dram/addr_map.h"
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+using namespace GNN;
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char* what, int banks, int lines)
+{
+  if (!ok)
+  {
+    std::printf("FAIL %s (banks=%d lines=%d)\n", what, banks, lines);
+    ++failures;
+  }
+}
+
+// 按 DmaBuffer 的取数规则展开某个 bank 依次读取的行地址
+std::vector<addr_t> bankLines(const DmaBuffer::DmaCommand& cmd, int bank, int banks)
+{
+  const addr_t                      stride = static_cast<addr_t>(banks) * DmaBuffer::addr_stride;
+  std::vector<DmaBuffer::DmaSegment> segs;
+  cmd.flatten(segs);
+  std::vector<addr_t> out;
+  for (const DmaBuffer::DmaSegment& seg : segs)
+  {
+    addr_t first = AddrInterleave::firstLine(seg.base_addr, bank, banks);
+    for (int i = 0; i < seg.lines; ++i)
+      out.push_back(first + static_cast<addr_t>(i) * stride);
+  }
+  return out;
+}
+
+// 一个权重缓冲切成：前半 2 行 2D（每行 1/4），后半两段聚集列表链在其后
+DmaBuffer::DmaCommand tiled(addr_t base, int lines, int banks)
+{
+  const addr_t          stride  = static_cast<addr_t>(banks) * DmaBuffer::addr_stride;
+  int                   quarter = lines / 4;
+  DmaBuffer::DmaCommand cmd{};
+  cmd.base_addr   = base;
+  cmd.rows        = 2;
+  cmd.total_lines = quarter;
+  cmd.row_stride  = static_cast<addr_t>(quarter) * stride;
+  auto gather     = std::make_shared<DmaBuffer::DmaCommand>();
+  gather->segments = { { base + static_cast<addr_t>(2 * quarter) * stride, quarter },
+                       { base + static_cast<addr_t>(3 * quarter) * stride, lines - 3 * quarter } };
+  cmd.next = gather;
+  return cmd;
+}
+
+} // namespace
+
+int main()
+{
+  for (int banks : { 1, 8, 16, 32 })
+    for (int lines : { 4, 7, 64, 129 })
+      for (addr_t base : { addr_t(0), addr_t(3 * DmaBuffer::addr_stride), addr_t(1 << 20) })
+      {
+        DmaBuffer::DmaCommand linear{};
+        linear.base_addr   = base;
+        linear.total_lines = lines;
+        DmaBuffer::DmaCommand tile = tiled(base, lines, banks);
+
+        std::vector<DmaBuffer::DmaSegment> segs;
+        check(linear.flatten(segs) == lines, "linear line count", banks, lines);
+        check(tile.flatten(segs) == lines, "tiled line count", banks, lines);
+        for (int bank = 0; bank < banks; ++bank)
+          check(bankLines(tile, bank, banks) == bankLines(linear, bank, banks), "tiled lines match linear", banks,
+                lines);
+
+        // WeightBank 行主序布局：每行 1 行、行距 1 行时与线性命令相同
+        DmaBuffer::DmaCommand rows{};
+        rows.base_addr   = base;
+        rows.rows        = lines;
+        rows.total_lines = 1;
+        rows.row_stride  = static_cast<addr_t>(banks) * DmaBuffer::addr_stride;
+        for (int bank = 0; bank < banks; ++bank)
+          check(bankLines(rows, bank, banks) == bankLines(linear, bank, banks), "row-major lines match linear", banks,
+                lines);
+      }
+
+  // 空段不占槽位
+  DmaBuffer::DmaCommand gather{};
+  gather.segments = { { 0, 0 }, { 4096, 2 }, { 8192, -1 } };
+  std::vector<DmaBuffer::DmaSegment> segs;
+  check(gather.flatten(segs) == 2 && segs.size() == 1, "empty segments dropped", 1, 2);
+
+  // 流检测：跨步连续两次相同才认定；行数变化或非线性命令不认定
+  StreamDetector stream;
+  const addr_t   step = 8 * DmaBuffer::addr_stride * 64;
+  for (int i = 0; i < 3; ++i)
+    stream.train(0x1000000 + i * step, 64);
+  check(!stream.confirmed(), "stream needs two matching strides", 8, 64);
+  stream.train(0x1000000 + 3 * step, 64);
+  check(stream.confirmed() && stream.stride == static_cast<int64_t>(step), "stream learns stride", 8, 64);
+  stream.train(0x1000000 + 4 * step, 32);
+  check(!stream.confirmed(), "line count change resets stream", 8, 32);
+  for (int i = 5; i < 9; ++i)
+    stream.train(0x1000000 + i * step, 0);
+  check(!stream.confirmed(), "non-linear commands never confirm", 8, 0);
+
+  std::printf("%s\n", failures ? "FAILED" : "PASSED");
+  return failures ? 1 : 0;
+}